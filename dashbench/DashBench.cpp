@@ -0,0 +1,241 @@
+#include "DashBench.h"
+
+#include <new>
+#include <cstdlib>
+#include <cmath>
+
+// every allocation in the process goes through here, so the count around
+// a frame is exactly what that frame allocated
+static QAtomicInt allocations(0);
+
+void *operator new(size_t size)
+{
+    allocations.fetchAndAddRelaxed(1);
+    void *p = malloc(size ? size : 1);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p)
+{
+    free(p);
+}
+
+void operator delete[](void *p)
+{
+    free(p);
+}
+
+quint32 AllocationCount()
+{
+    return (quint32)(int)allocations;
+}
+
+SensorStream::SensorStream()
+{
+    seed = 12345;
+}
+
+double SensorStream::Noise()
+{
+    seed = seed * 1103515245 + 12345;
+    return ((seed >> 16) & 0x7fff) / 16383.5 - 1.0;
+}
+
+void SensorStream::Ecu(int ms, ecustate_t *state)
+{
+    // revs sweep up and down every few seconds, with some jitter
+    double t = ms / 1000.0;
+    state->timestamp = ms;
+    state->rpm = (int)(3500.0 + 2500.0 * sin(2.0 * M_PI * t / 4.0) + 50.0 * Noise());
+    state->spark_adv = 20.0 + 5.0 * sin(t);
+    state->cranking = false;
+    state->map = 60.0 + 30.0 * sin(2.0 * M_PI * t / 4.0);
+    state->mat = 80.0;
+    state->clt = 180.0 + 0.01 * t;
+    state->tps = 50.0 + 45.0 * sin(2.0 * M_PI * t / 4.0);
+    state->batt = 13.8 + 0.1 * Noise();
+    state->maf = 900.0 + 300.0 * sin(2.0 * M_PI * t / 4.0);
+    state->tach_count = ms / 10;
+    state->acquired = LatencyClock::Now();
+}
+
+void SensorStream::Gps(int ms, gpsstate_t *state)
+{
+    double t = ms / 1000.0;
+    state->timestamp = ms;
+    state->utc_hrs = 12;
+    state->utc_mins = (ms / 60000) % 60;
+    state->utc_secs = fmod(t, 60.0);
+    state->pos.lat_deg = 35;
+    state->pos.lat_mins = 15.0 + 0.01 * sin(t / 30.0);
+    state->pos.lat_dir = GPS_NORTH;
+    state->pos.long_deg = 120;
+    state->pos.long_mins = 40.0 + 0.01 * cos(t / 30.0);
+    state->pos.long_dir = GPS_WEST;
+    state->alt = 100.0;
+    state->speed = 20.0 + 10.0 * sin(2.0 * M_PI * t / 20.0) + 0.2 * Noise();
+    state->heading = fmod(t * 12.0, 360.0);
+    state->acquired = LatencyClock::Now();
+}
+
+void SensorStream::Imu(int ms, imustate_t *state)
+{
+    double t = ms / 1000.0;
+    state->timestamp = ms;
+    state->ax = 0.3 * sin(2.0 * M_PI * t / 20.0) + 0.05 * Noise();
+    state->ay = 0.05 * Noise();
+    state->az = 0.2 * cos(2.0 * M_PI * t / 4.0) + 0.05 * Noise();
+    state->gx = 2.0 * Noise();
+    state->gy = 2.0 * Noise();
+    state->gz = 18.0 * sin(2.0 * M_PI * t / 20.0);
+    state->acquired = LatencyClock::Now();
+}
+
+static double Percentile(QVector<qint64> &samples, double fraction)
+{
+    if (samples.isEmpty()) return 0.0;
+    int index = qMin((int)(fraction * samples.size()), samples.size() - 1);
+    return samples[index] / 1000000.0;
+}
+
+benchresult_t BenchScenario::Run(int rate, int frames)
+{
+    QWidget *widget = Widget();
+
+    // render into an offscreen image, exactly like the kiosk renderer
+    OffscreenOutput *output = new OffscreenOutput();
+    KioskRenderer renderer(widget, output);
+    renderer.Start();
+    widget->show(); // never reaches the screen, but lays everything out
+
+    QVector<qint64> paint_ns, feed_ns;
+    paint_ns.reserve(frames);
+    feed_ns.reserve(frames);
+
+    // warm up caches (dial pixmaps, glyph atlases) before measuring
+    fed_ms = 0;
+    renderer.RenderFrame();
+
+    QElapsedTimer wall, timer;
+    quint64 allocs = 0;
+    wall.start();
+    for (int frame = 1; frame <= frames; frame++)
+    {
+        int ms = frame * 1000 / BENCH_FRAME_RATE;
+
+        quint32 before = AllocationCount();
+        timer.start();
+        Feed(ms, rate);
+        QApplication::processEvents();
+        feed_ns.append(timer.nsecsElapsed());
+
+        timer.start();
+        renderer.RenderFrame();
+        paint_ns.append(timer.nsecsElapsed());
+        allocs += (quint32)(AllocationCount() - before); // wraps safely
+    }
+    qint64 total_ns = wall.nsecsElapsed();
+
+    renderer.Stop();
+
+    qSort(paint_ns);
+    qSort(feed_ns);
+
+    benchresult_t result;
+    result.scenario = Name();
+    result.rate = rate;
+    result.frames = frames;
+    result.paint_p50_ms = Percentile(paint_ns, 0.50);
+    result.paint_p99_ms = Percentile(paint_ns, 0.99);
+    result.feed_p99_ms = Percentile(feed_ns, 0.99);
+    result.allocs_per_frame = (double)allocs / frames;
+    result.fps = (total_ns > 0) ? frames * 1.0e9 / total_ns : 0.0;
+    return result;
+}
+
+NeedleScenario::NeedleScenario(bool anim, bool dial_cached)
+{
+    animated = anim;
+    cached = dial_cached;
+    needle = new QNeedleIndicator();
+    needle->resize(256, 256);
+    needle->setRange(TACH_MIN, TACH_MAX);
+    needle->setMajorTicks(TACH_MAX / 1000 + 1);
+    needle->setMinorTicks(9);
+    needle->setDigitFormat(QString("%.0f"));
+    needle->setLabel(QString("RPM"));
+    needle->setAnimated(animated);
+    needle->setDialCached(cached);
+}
+
+QString NeedleScenario::Name()
+{
+    if (!cached) return "needle (uncached)";
+    return animated ? "needle (animated)" : "needle";
+}
+
+NeedleScenario::~NeedleScenario()
+{
+    delete needle;
+}
+
+void NeedleScenario::Feed(int ms, int rate)
+{
+    ecustate_t state;
+    int step = qMax(1000 / rate, 1);
+    for (; fed_ms + step <= ms; fed_ms += step)
+    {
+        stream.Ecu(fed_ms, &state);
+        needle->setValue(state.rpm);
+    }
+}
+
+DashboardScenario::DashboardScenario()
+{
+    // the dashboard keeps its files in the working directory
+    previous_dir = QDir::currentPath();
+    scratch_dir = QDir::temp().absoluteFilePath(QString("dashbench_%1").arg(QCoreApplication::applicationPid()));
+    QDir().mkpath(scratch_dir);
+    QDir::setCurrent(scratch_dir);
+
+    dashboard = new Dashboard();
+    dashboard->resize(SCREEN_WIDTH, SCREEN_HEIGHT);
+}
+
+DashboardScenario::~DashboardScenario()
+{
+    delete dashboard;
+
+    // leave nothing behind, the next scenario starts from empty too
+    QDir::setCurrent(previous_dir);
+    QDir scratch(scratch_dir);
+    QStringList files = scratch.entryList(QDir::Files | QDir::Hidden);
+    for (int i = 0; i < files.size(); i++) scratch.remove(files[i]);
+    QDir().rmdir(scratch_dir);
+}
+
+void DashboardScenario::Feed(int ms, int rate)
+{
+    // ecu at the full rate, gps and the run timer at a tenth of it,
+    // about the ratio the car's hardware runs at
+    ecustate_t ecu;
+    gpsstate_t gps;
+    int step = qMax(1000 / rate, 1);
+    for (; fed_ms + step <= ms; fed_ms += step)
+    {
+        stream.Ecu(fed_ms, &ecu);
+        dashboard->EcuUpdate(ecu);
+        if ((fed_ms / step) % 10 == 0)
+        {
+            stream.Gps(fed_ms, &gps);
+            dashboard->GpsUpdate(gps);
+            dashboard->TmrUpdate(fed_ms);
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef DASHBENCH_H
+#define DASHBENCH_H
+
+#include <QObject>
+#include <QWidget>
+#include <QString>
+#include <QDir>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QApplication>
+#include <QAtomicInt>
+#include <QtAlgorithms>
+
+#include "ucvtypes.h"
+#include "KioskRenderer.h"
+#include "Dashboard.h"
+#include "qneedleindicator.h"
+
+// the display rate frames are rendered at (in frames per second)
+#define BENCH_FRAME_RATE 60
+
+// number of allocations made since the program started (wrapping), counted
+// by the global operator new in DashBench.cpp
+quint32 AllocationCount();
+
+// deterministic, made up sensor data that moves around like a real run
+class SensorStream
+{
+public:
+    SensorStream();
+    void Ecu(int ms, ecustate_t *state);
+    void Gps(int ms, gpsstate_t *state);
+    void Imu(int ms, imustate_t *state);
+
+private:
+    quint32 seed;
+    double Noise(); // -1 to 1
+};
+
+typedef struct benchresult_struct {
+    QString scenario;
+    int rate; // sensor samples per second
+    int frames;
+    double paint_p50_ms;
+    double paint_p99_ms;
+    double feed_p99_ms; // time spent delivering samples and events per frame
+    double allocs_per_frame;
+    double fps; // frames per second of wall time, rendering as fast as possible
+} benchresult_t;
+
+// one kind of widget fed at one sample rate, every frame is rendered into
+// an offscreen image exactly the way the kiosk renderer does it
+class BenchScenario
+{
+public:
+    virtual ~BenchScenario() {}
+    virtual QString Name() = 0;
+    virtual QWidget *Widget() = 0;
+
+    // deliver every sample due up to ms
+    virtual void Feed(int ms, int rate) = 0;
+
+    benchresult_t Run(int rate, int frames);
+
+protected:
+    SensorStream stream;
+    int fed_ms; // time of the last sample delivered
+};
+
+// a single QNeedleIndicator showing rpm
+class NeedleScenario : public BenchScenario
+{
+public:
+    // uncached draws the whole dial every paint, what the needle cost
+    // before the dial pixmap
+    NeedleScenario(bool animated, bool cached = true);
+    ~NeedleScenario();
+    QString Name();
+    QWidget *Widget() { return needle; }
+    void Feed(int ms, int rate);
+
+private:
+    QNeedleIndicator *needle;
+    bool animated;
+    bool cached;
+};
+
+// the whole dashboard, fed ecu, gps and timer updates
+// it runs in an empty scratch directory of its own, so it never resumes
+// (or overwrites) a run checkpoint or reference lap that's lying around
+class DashboardScenario : public BenchScenario
+{
+public:
+    DashboardScenario();
+    ~DashboardScenario();
+    QString Name() { return "dashboard"; }
+    QWidget *Widget() { return dashboard; }
+    void Feed(int ms, int rate);
+
+private:
+    Dashboard *dashboard;
+    QString previous_dir;
+    QString scratch_dir;
+};
+
+#endif // DASHBENCH_H
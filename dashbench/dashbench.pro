@@ -0,0 +1,53 @@
+# -------------------------------------------------
+# Offscreen rendering benchmark for the dashboard widgets
+#
+# nothing is drawn on screen, but a QApplication still has to start and
+# Qt 4 on X11 can't do that without a display, so a headless machine
+# needs xvfb-run (e.g. xvfb-run ./dashbench) or a QWS build of Qt
+# -------------------------------------------------
+TARGET = dashbench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+INCLUDEPATH += ../dashboard
+SOURCES += main.cpp \
+    DashBench.cpp \
+    ../dashboard/Dashboard.cpp \
+    ../dashboard/Options.cpp \
+    ../dashboard/LogCopyJob.cpp \
+    ../dashboard/LogCatalog.cpp \
+    ../dashboard/LogReader.cpp \
+    ../dashboard/PaintStats.cpp \
+    ../dashboard/DigitReadout.cpp \
+    ../dashboard/KioskRenderer.cpp \
+    ../dashboard/LatencyMonitor.cpp \
+    ../dashboard/StatusChannel.cpp \
+    ../dashboard/RunClock.cpp \
+    ../dashboard/RunCheckpoint.cpp \
+    ../dashboard/StripChart.cpp \
+    ../dashboard/GGDiagram.cpp \
+    ../dashboard/LocalProjection.cpp \
+    ../dashboard/ReferenceLap.cpp \
+    ../dashboard/TrackMap.cpp \
+    ../dashboard/qneedleindicator.cpp
+HEADERS += DashBench.h \
+    ../dashboard/Dashboard.h \
+    ../dashboard/Options.h \
+    ../dashboard/LogCopyJob.h \
+    ../dashboard/LogCatalog.h \
+    ../dashboard/LogReader.h \
+    ../dashboard/PaintStats.h \
+    ../dashboard/DigitReadout.h \
+    ../dashboard/KioskRenderer.h \
+    ../dashboard/LatencyMonitor.h \
+    ../dashboard/StatusChannel.h \
+    ../dashboard/RunClock.h \
+    ../dashboard/RunCheckpoint.h \
+    ../dashboard/StripChart.h \
+    ../dashboard/GGDiagram.h \
+    ../dashboard/LocalProjection.h \
+    ../dashboard/ReferenceLap.h \
+    ../dashboard/TrackMap.h \
+    ../dashboard/qneedleindicator.h \
+    ../dashboard/ucvtypes.h
+win32:LIBS += -lws2_32
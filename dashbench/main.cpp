@@ -0,0 +1,99 @@
+#include <QApplication>
+#include <QStringList>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "DashBench.h"
+
+// the dashboard's options page refers to this (it's defined by Hardware)
+bool g_imu_zero = false;
+
+static void Usage()
+{
+    fprintf(stderr, "usage: dashbench [--frames n] [--rates hz,hz,...]\n");
+    fprintf(stderr, "renders the dashboard widgets offscreen fed with made up sensor data\n");
+    fprintf(stderr, "requires a display: Qt 4 on X11 can't start a QApplication without one,\n");
+    fprintf(stderr, "so on a headless machine run it under xvfb-run (or build Qt for QWS)\n");
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef Q_WS_X11
+    // say why up front rather than leaving it to Qt's "cannot connect"
+    if (getenv("DISPLAY") == NULL)
+    {
+        fprintf(stderr, "dashbench: no DISPLAY set\n");
+        Usage();
+        return 1;
+    }
+#endif
+
+    QApplication app(argc, argv);
+    QStringList args = app.arguments();
+
+    int frames = 10 * BENCH_FRAME_RATE;
+    QList<int> rates;
+    rates << 10 << 50 << 200 << 1000;
+    for (int i = 1; i < args.size(); i++)
+    {
+        if (args[i] == "--frames" && i + 1 < args.size())
+        {
+            frames = args[++i].toInt();
+        }
+        else if (args[i] == "--rates" && i + 1 < args.size())
+        {
+            rates.clear();
+            QStringList list = args[++i].split(",", QString::SkipEmptyParts);
+            for (int r = 0; r < list.size(); r++)
+            {
+                if (list[r].toInt() > 0) rates.append(list[r].toInt());
+            }
+        }
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+    if (frames < 1 || rates.isEmpty())
+    {
+        Usage();
+        return 1;
+    }
+
+    printf("%-20s %7s %7s %10s %10s %10s %12s %8s\n", "scenario", "rate", "frames",
+           "paint p50", "paint p99", "feed p99", "allocs/frame", "fps");
+
+    for (int r = 0; r < rates.size(); r++)
+    {
+        for (int s = 0; s < 4; s++)
+        {
+            BenchScenario *scenario;
+            if (s == 0)
+            {
+                scenario = new NeedleScenario(false, false);
+            }
+            else if (s == 1)
+            {
+                scenario = new NeedleScenario(false);
+            }
+            else if (s == 2)
+            {
+                scenario = new NeedleScenario(true);
+            }
+            else
+            {
+                scenario = new DashboardScenario();
+            }
+
+            benchresult_t result = scenario->Run(rates[r], frames);
+            printf("%-20s %5dHz %7d %8.3fms %8.3fms %8.3fms %12.1f %8.0f\n", qPrintable(result.scenario),
+                   result.rate, result.frames, result.paint_p50_ms, result.paint_p99_ms,
+                   result.feed_p99_ms, result.allocs_per_frame, result.fps);
+            delete scenario;
+        }
+    }
+
+    return 0;
+}
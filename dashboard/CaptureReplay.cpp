@@ -0,0 +1,182 @@
+#include "CaptureReplay.h"
+
+CaptureReplay::CaptureReplay(SensorParser *sensor_parser, QObject *parent)
+    : QObject(parent)
+{
+    parser = sensor_parser;
+    capfile = NULL;
+    data = NULL;
+    size = 0;
+    pos = 0;
+    clock = &wall_clock;
+    speed = 1.0;
+    running = false;
+    first_timestamp = 0;
+    next_tick = 0;
+
+    timer = new QTimer(this);
+    timer->setInterval(REPLAY_STEP_MS);
+    connect(timer, SIGNAL(timeout()), this, SLOT(Step()));
+}
+
+CaptureReplay::~CaptureReplay()
+{
+    Close();
+}
+
+bool CaptureReplay::Open(QString filepath)
+{
+    Close();
+
+    capfile = new QFile(filepath);
+    if (!capfile->open(QIODevice::ReadOnly))
+    {
+        delete capfile;
+        capfile = NULL;
+        return false;
+    }
+
+    // captures are replayed straight out of the page cache
+    size = capfile->size();
+    data = (size > 0) ? capfile->map(0, size) : NULL;
+    if (data == NULL)
+    {
+        Close();
+        return false;
+    }
+
+    pos = 0;
+    first_timestamp = HaveChunk() ? ChunkTimestamp() : 0;
+    next_tick = (first_timestamp / 1000 + 1) * 1000;
+
+    return true;
+}
+
+void CaptureReplay::Close()
+{
+    Stop();
+
+    if (capfile != NULL)
+    {
+        capfile->close();
+        delete capfile;
+        capfile = NULL;
+    }
+
+    data = NULL;
+    size = 0;
+    pos = 0;
+}
+
+void CaptureReplay::SetClock(ReplayClock *replay_clock)
+{
+    clock = (replay_clock != NULL) ? replay_clock : &wall_clock;
+}
+
+void CaptureReplay::Start()
+{
+    if (running || data == NULL) return;
+
+    running = true;
+    clock->Start();
+    timer->start();
+}
+
+void CaptureReplay::Stop()
+{
+    if (!running) return;
+
+    timer->stop();
+    running = false;
+}
+
+int CaptureReplay::RunToEnd()
+{
+    int count = 0;
+
+    while (HaveChunk())
+    {
+        EmitTicksUntil(ChunkTimestamp());
+        FeedChunk();
+        count++;
+    }
+
+    Finish();
+    return count;
+}
+
+void CaptureReplay::Step()
+{
+    if (speed <= REPLAY_MAX_SPEED)
+    {
+        for (int i = 0; i < REPLAY_MAX_BATCH && HaveChunk(); i++)
+        {
+            EmitTicksUntil(ChunkTimestamp());
+            FeedChunk();
+        }
+    }
+    else
+    {
+        int now = first_timestamp + (int)(clock->Elapsed() * speed);
+        while (HaveChunk() && ChunkTimestamp() <= now)
+        {
+            EmitTicksUntil(ChunkTimestamp());
+            FeedChunk();
+        }
+        EmitTicksUntil(now);
+    }
+
+    if (!HaveChunk()) Finish();
+}
+
+bool CaptureReplay::HaveChunk()
+{
+    if (data == NULL || size - pos < CAPTURE_HEADER_SIZE) return false;
+
+    // a chunk cut short by a crash ends the capture
+    int len = qFromBigEndian<quint16>(data + pos + 5);
+    return size - pos - CAPTURE_HEADER_SIZE >= len;
+}
+
+void CaptureReplay::FeedChunk()
+{
+    quint8 channel = data[pos];
+    int timestamp = ChunkTimestamp();
+    int len = qFromBigEndian<quint16>(data + pos + 5);
+    const char *buf = (const char *)data + pos + CAPTURE_HEADER_SIZE;
+    pos += CAPTURE_HEADER_SIZE + len;
+
+    switch (channel)
+    {
+    case CAPTURE_ECU:
+        parser->FeedEcu(buf, len, timestamp);
+        break;
+    case CAPTURE_GPS:
+        parser->FeedGps(buf, len, timestamp);
+        break;
+    case CAPTURE_IMU:
+        parser->FeedImu(buf, len, timestamp);
+        break;
+    case CAPTURE_ECU_REQUEST:
+        parser->EcuRequest();
+        break;
+    case CAPTURE_IMU_ZERO:
+        parser->ZeroImu();
+        break;
+    }
+}
+
+void CaptureReplay::EmitTicksUntil(int timestamp)
+{
+    while (next_tick <= timestamp)
+    {
+        emit TmrTick(next_tick);
+        next_tick += 1000;
+    }
+}
+
+void CaptureReplay::Finish()
+{
+    Stop();
+    emit ReplayFinished();
+}
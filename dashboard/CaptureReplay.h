@@ -0,0 +1,72 @@
+#ifndef CAPTUREREPLAY_H
+#define CAPTUREREPLAY_H
+
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QString>
+#include <QtEndian>
+
+#include "LogReplay.h"
+#include "SensorParser.h"
+#include "UartCapture.h"
+
+// feeds a raw uart capture back into a SensorParser with the exact
+// chunk boundaries seen in the car, either on the original timeline
+// (scaled like a LogReplay) or as fast as memory allows
+class CaptureReplay : public QObject
+{
+    Q_OBJECT
+
+public:
+    // the replay does not take ownership of the parser
+    CaptureReplay(SensorParser *sensor_parser, QObject *parent = 0);
+    ~CaptureReplay();
+
+    bool Open(QString filepath);
+    void Close();
+
+    // same meaning as LogReplay::SetSpeed
+    void SetSpeed(double factor) { speed = factor; }
+
+    // the replay does not take ownership of the clock
+    void SetClock(ReplayClock *replay_clock);
+
+    bool IsRunning() { return running; }
+
+    // feeds every remaining chunk without returning to the event loop,
+    // returns the number of chunks fed
+    int RunToEnd();
+
+public slots:
+    void Start();
+    void Stop();
+    void Step();
+
+signals:
+    void TmrTick(int ms);
+    void ReplayFinished();
+
+private:
+    SensorParser *parser;
+    QFile *capfile;
+    const uchar *data;
+    qint64 size;
+    qint64 pos;
+
+    WallClock wall_clock;
+    ReplayClock *clock;
+    QTimer *timer;
+    double speed;
+    bool running;
+    int first_timestamp;
+    int next_tick;
+
+    bool HaveChunk();
+    int ChunkTimestamp() { return qFromBigEndian<qint32>(data + pos + 1); }
+    void FeedChunk();
+    void EmitTicksUntil(int timestamp);
+    void Finish();
+};
+
+#endif // CAPTUREREPLAY_H
@@ -1,5 +1,7 @@
 #include "Dashboard.h"
 
+#include <cstring>
+
 Dashboard::Dashboard(QWidget *parent)
     : QWidget(parent)
 {
@@ -9,10 +11,12 @@ Dashboard::Dashboard(QWidget *parent)
     QGroupBox *lap_timers = new QGroupBox("Lap Timing");
     QGroupBox *button_box = new QGroupBox("Controls");
     QGroupBox *tachspeed_box = new QGroupBox("Tach/Speed");
+    QGroupBox *trends_box = new QGroupBox("Trends");
 
     QGridLayout *lap_timers_layout = new QGridLayout();
     QGridLayout *button_layout = new QGridLayout();
     QGridLayout *tachspeed_layout = new QGridLayout();
+    QGridLayout *trends_layout = new QGridLayout();
     QGridLayout *layout = new QGridLayout();
 
     // build lap timers
@@ -26,27 +30,49 @@ Dashboard::Dashboard(QWidget *parent)
         int lap_finish_secs = expected_lap_secs[i] % 60;
         lap_expected_time[i] = new QLabel(QString("<h3>%1:%2</h3>").arg(lap_finish_mins).arg(lap_finish_secs, 2, 10, QChar('0')));
 
-        lap_actual_time[i] = new QLabel("<h2><font color='grey'>0:00</font></h2>");
+        lap_actual_time[i] = new DigitReadout();
+        lap_actual_time[i]->setFont(QFont("Fixed", LABEL_FONT_SIZE + 4, QFont::Bold));
+        lap_actual_time[i]->SetHintChars(9);
+        lap_actual_time[i]->SetTime(0, 0, READOUT_IDLE);
 
         lap_timers_layout->addWidget(lap_number[i], i, 0);
         lap_timers_layout->addWidget(lap_expected_time[i], i, 1);
         lap_timers_layout->addWidget(lap_actual_time[i], i, 2);
     }
 
+    // live pace against the reference lap
+    ref_delta_label = new QLabel("<h3>Delta</h3>");
+    ref_delta = new DigitReadout();
+    ref_delta->setFont(QFont("Fixed", LABEL_FONT_SIZE + 4, QFont::Bold));
+    ref_delta->SetSuffix(" s");
+    ref_delta->SetNumber(0, 1, READOUT_IDLE);
+    finish_label = new QLabel("<h3>Finish</h3>");
+    predicted_finish = new DigitReadout();
+    predicted_finish->setFont(QFont("Fixed", LABEL_FONT_SIZE + 4, QFont::Bold));
+    predicted_finish->SetTime(0, 0, READOUT_IDLE);
+    lap_timers_layout->addWidget(ref_delta_label, NUMBER_OF_LAPS, 0, 1, 2);
+    lap_timers_layout->addWidget(ref_delta, NUMBER_OF_LAPS, 2);
+    lap_timers_layout->addWidget(finish_label, NUMBER_OF_LAPS + 1, 0, 1, 2);
+    lap_timers_layout->addWidget(predicted_finish, NUMBER_OF_LAPS + 1, 2);
+
     // control buttons
     run_status = new QLabel("<font color='red'>Stopped</font>");
     run_status->setAlignment(Qt::AlignCenter);
     run_status->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
     start_button = new QPushButton("Start Run");
     start_button->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
+    arm_button = new QPushButton("Arm");
+    arm_button->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
+    arm_button->setCheckable(true);
     next_lap_button = new QPushButton("Next Lap");
     next_lap_button->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
     options_button = new QPushButton("Options");
     options_button->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
     button_layout->addWidget(run_status, 0, 0);
     button_layout->addWidget(start_button, 0, 1);
-    button_layout->addWidget(next_lap_button, 0, 2);
-    button_layout->addWidget(options_button, 0, 3);
+    button_layout->addWidget(arm_button, 0, 2);
+    button_layout->addWidget(next_lap_button, 0, 3);
+    button_layout->addWidget(options_button, 0, 4);
 
     // tach/speed
     atach = new QNeedleIndicator(this);
@@ -65,15 +91,18 @@ Dashboard::Dashboard(QWidget *parent)
     aspeed->setDigitFont(QFont("Fixed", 10, QFont::Bold));
     aspeed->setLabel(QString("Speed"));
 
-    dtach = new QLabel("0.0 rpm");
-    dtach->setAlignment(Qt::AlignCenter);
-    dtach->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
-    dspeed = new QLabel("0.0 mph");
-    dspeed->setAlignment(Qt::AlignCenter);
+    dtach = new DigitReadout();
+    dtach->setFont(QFont("Fixed", 2 * BUTTON_FONT_SIZE, QFont::Bold));
+    dtach->SetSuffix(" rpm");
+    dtach->SetNumber(0);
+    dspeed = new DigitReadout();
     dspeed->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
-    davgspeed = new QLabel("0.0 avg");
-    davgspeed->setAlignment(Qt::AlignCenter);
+    dspeed->SetSuffix(" mph");
+    dspeed->SetNumber(0, 1);
+    davgspeed = new DigitReadout();
     davgspeed->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
+    davgspeed->SetSuffix(" avg");
+    davgspeed->SetNumber(0, 1);
 
 
     tachspeed_layout->addWidget(atach, 0, 0);
@@ -83,13 +112,31 @@ Dashboard::Dashboard(QWidget *parent)
     tachspeed_layout->addWidget(davgspeed, 2, 1);
     tachspeed_layout->setRowStretch(0, 1);
 
+    // trends over the last minute
+    trends = new StripChart();
+    trend_rpm = trends->AddChannel("RPM", TACH_MIN, TACH_MAX, Qt::red);
+    trend_speed = trends->AddChannel("Speed", SPEED_MIN, SPEED_MAX, Qt::blue);
+    trend_lat_g = trends->AddChannel("Lateral G", -1.0, 1.0, Qt::darkGreen);
+    trends_layout->addWidget(trends, 0, 0);
+
+    // friction circle beside it
+    gg = new GGDiagram();
+    trends_layout->addWidget(gg, 0, 1);
+
+    // and where the car is on the track
+    track_map = new TrackMap();
+    trends_layout->addWidget(track_map, 0, 2);
+    trends_layout->setColumnStretch(0, 1);
+
     // master layout
     lap_timers->setLayout(lap_timers_layout);
     button_box->setLayout(button_layout);
     tachspeed_box->setLayout(tachspeed_layout);
+    trends_box->setLayout(trends_layout);
     layout->addWidget(lap_timers, 0, 0, 2, 1);
     layout->addWidget(button_box, 0, 1);
     layout->addWidget(tachspeed_box, 1, 1);
+    layout->addWidget(trends_box, 2, 0, 1, 2);
     layout->setColumnStretch(1, 1);
     layout->setRowStretch(1, 1);
 
@@ -102,38 +149,118 @@ Dashboard::Dashboard(QWidget *parent)
     avgspeed_numerator = 0.0;
     avgspeed_denominator = 0;
     run_in_progress = false;
+    lap_start_ms = 0;
+    start_pressed = 0;
+    ref_distance = -1.0;
 
     // create options window
     options = new Options();
 
+    // pace against the saved reference lap (if there is one) and draw
+    // it under the trail
+    if (reference.Load(REFLAP_FILENAME))
+    {
+        reference.Prepare();
+        track_map->SetReference(reference);
+    }
+    connect(options, SIGNAL(SetReferenceLap()), this, SLOT(SaveReferenceLap()));
+    connect(options, SIGNAL(SetStartFinish()), this, SIGNAL(SetStartFinish()));
+
+    // sensor-to-pixel latency, shown on top of everything when switched on
+    latency = LatencyMonitor::instance();
+    latency_overlay = new LatencyOverlay(this);
+    latency_overlay->move(SCREEN_WIDTH - latency_overlay->width() - 10, 10);
+    connect(atach, SIGNAL(painted(int)), this, SLOT(RpmPainted(int)));
+    connect(dtach, SIGNAL(Painted(int)), this, SLOT(RpmPainted(int)));
+    connect(aspeed, SIGNAL(painted(int)), this, SLOT(SpeedPainted(int)));
+    connect(dspeed, SIGNAL(Painted(int)), this, SLOT(SpeedPainted(int)));
+    connect(options, SIGNAL(LatencyOverlayToggled(bool)), latency_overlay, SLOT(setVisible(bool)));
+
+    // sensor faults and events come up across the top without stopping anything
+    status_banner = new StatusBanner(this);
+    status_banner->resize(SCREEN_WIDTH, status_banner->height());
+    connect(StatusChannel::instance(), SIGNAL(StatusPosted(int, int, QString)),
+            status_banner, SLOT(Post(int, int, QString)));
+
     // connect up signals and slots
+    // (the lap button acts on the press, which is when the driver meant
+    // it, rather than on the release, start/stop still acts on the click
+    // so a brushed touch can slide off without ending a run, but the run
+    // is timed from the press)
+    connect(start_button, SIGNAL(pressed()), this, SLOT(StartRunButtonPressed()));
     connect(start_button, SIGNAL(clicked()), this, SLOT(StartRunButtonClicked()));
-    connect(next_lap_button, SIGNAL(clicked()), this, SLOT(NextLap()));
+    connect(next_lap_button, SIGNAL(pressed()), this, SLOT(NextLap()));
+    connect(arm_button, SIGNAL(toggled(bool)), this, SLOT(ArmButtonToggled(bool)));
     connect(options_button, SIGNAL(clicked()), this, SLOT(OptionsButtonClicked()));
 
+    // with --kiosk the dashboard draws itself straight into the linux
+    // framebuffer and takes the touch screen directly, no desktop needed
+    // (linux builds only, see KioskRenderer.h for what it still relies on)
+    bool kiosk_mode = false;
+#ifdef Q_OS_LINUX
+    kiosk = NULL;
+    kiosk_touch = NULL;
+    if (QApplication::arguments().contains("--kiosk"))
+    {
+        kiosk = new KioskRenderer(this, new FramebufferOutput(), this);
+        kiosk_mode = kiosk->Start();
+        kiosk_touch = new KioskTouch(this, KIOSK_TOUCH_DEVICE, this);
+
+        // the options page (and any message box) is drawn over the
+        // dashboard while it's up, and touches go to it
+        connect(kiosk, SIGNAL(TopChanged(QWidget *, QPoint)), kiosk_touch, SLOT(SetRoot(QWidget *, QPoint)));
+    }
+#endif
+
+    // if the last dashboard died mid-run, carry on with it
+    for (int i = 0; i < NUMBER_OF_LAPS; i++)
+    {
+        lap_finish_ms[i] = 0;
+    }
+    checkpoint.Open(RUNCKPT_FILENAME);
+    ResumeRun();
+
     // go full screen if in production mode
 #ifdef RUNNING_IN_CAR
-    showFullScreen();
+    if (!kiosk_mode) showFullScreen();
 #endif
 }
 
 Dashboard::~Dashboard()
 {
-    // nothing yet
+    // the options page is a window of its own rather than one of our
+    // children (hidden first so the kiosk lets go of it)
+    options->hide();
+    delete options;
 }
 
 void Dashboard::EcuUpdate(ecustate_t state)
 {
+    latency->Delivered(LAT_RPM, state.acquired);
+
     // update the tachometer
     atach->setValue(state.rpm);
-    dtach->setText(QString("<h1>%1 rpm</h1>").arg(state.rpm));
+    dtach->SetNumber(state.rpm);
+    trends->AddSample(trend_rpm, state.rpm);
 }
 
 void Dashboard::GpsUpdate(gpsstate_t state)
 {
+    latency->Delivered(LAT_SPEED, state.acquired);
+
     // update the speedometer
     aspeed->setValue((int)(state.speed));
-    dspeed->setText(QString("%1 mph").arg(state.speed, 2, 'f', 1, QChar('0')));
+    dspeed->SetNumber(qRound(state.speed * 10.0), 1);
+    trends->AddSample(trend_speed, state.speed);
+
+    // show the car on the map and trace this lap in case it becomes
+    // the next reference
+    track_map->GpsUpdate(state);
+    if (run_in_progress && LocalProjection::HasFix(state.pos))
+    {
+        lap_trace.Add(state.pos, state.timestamp - lap_start_ms);
+        UpdatePace(state);
+    }
 
     // update the average speed
         // IMPORTANT NOTE: this assumes the updates are coming in from the gps
@@ -147,30 +274,37 @@ void Dashboard::GpsUpdate(gpsstate_t state)
         if (avgspeed_denominator != 0)
         {
             double avgspeed = avgspeed_numerator / (double)avgspeed_denominator;
-            davgspeed->setText(QString("%1 avg").arg(avgspeed, 2, 'f', 1, QChar('0')));
+            davgspeed->SetNumber(qRound(avgspeed * 10.0), 1);
         }
+        SaveCheckpoint();
     }
 }
 
+void Dashboard::ImuUpdate(imustate_t state)
+{
+    // ax is lateral (driver left/right) after the parser remaps the axes
+    trends->AddSample(trend_lat_g, state.ax);
+    gg->ImuUpdate(state);
+}
+
 void Dashboard::TmrUpdate(int ms)
 {
     current_secs = ms / 1000;
 
-    // update the current lap timer
-    int mins = current_secs / 60;
-    int secs = current_secs % 60;
-    QString lap_time_str;
+    // all laps are done, nothing left to time
+    if (current_lap >= NUMBER_OF_LAPS) return;
+
+    // update the current lap timer, green while we're on target and red
+    // once we're behind schedule (the readout only repaints digits that
+    // changed, so ticking faster than once a second costs nothing)
     if (current_secs <= expected_lap_secs[current_lap])
     {
-        // we're on target
-        lap_time_str = QString("<h2><font color='green'>%1:%2</font></h2>").arg(mins).arg(secs, 2, 10, QChar('0'));
+        lap_actual_time[current_lap]->SetTime(current_secs, 0, READOUT_GOOD);
     }
     else
     {
-        // we're behind schedule
-        lap_time_str = QString("<h2><font color='red'>%1:%2</font></h2>").arg(mins).arg(secs, 2, 10, QChar('0'));
+        lap_actual_time[current_lap]->SetTime(current_secs, 0, READOUT_BAD);
     }
-    lap_actual_time[current_lap]->setText(lap_time_str);
 }
 
 void Dashboard::OptionsButtonClicked()
@@ -183,22 +317,21 @@ void Dashboard::OptionsButtonClicked()
     options->activateWindow();
 }
 
+void Dashboard::StartRunButtonPressed()
+{
+    start_pressed = LatencyClock::Now();
+}
+
 void Dashboard::StartRunButtonClicked()
 {
     if (!run_in_progress)
     {
-        // start the run        
-        start_button->setText("Stop Run");
-        run_status->setText("<font color='green'>Running</font>");
-        for (int i = 0; i < NUMBER_OF_LAPS; i++)
-        {
-            lap_actual_time[i]->setText("<h2><font color='grey'>0:00</font></h2>");
-        }
-        run_in_progress = true;
-        current_lap = 0;
-        avgspeed_numerator = 0.0;
-        avgspeed_denominator = 0;
-        emit StartRun();
+        // the clock starts on StartRun, so save the run's origin after
+        BeginRun();
+        if (start_pressed == 0) start_pressed = LatencyClock::Now();
+        emit StartRun(start_pressed);
+        start_pressed = 0;
+        SaveCheckpoint();
     }
     else
     {
@@ -206,16 +339,92 @@ void Dashboard::StartRunButtonClicked()
         start_button->setText("Start Run");
         run_status->setText("<font color='red'>Stopped</font>");
         run_in_progress = false;
+        SaveCheckpoint();
         emit StopRun();
     }
 }
 
+void Dashboard::ArmButtonToggled(bool checked)
+{
+    if (run_in_progress) return;
+
+    // while armed the run starts itself off the rpm or speed
+    if (checked)
+    {
+        run_status->setText("<font color='orange'>Armed</font>");
+    }
+    else
+    {
+        run_status->setText("<font color='red'>Stopped</font>");
+    }
+    emit ArmRun(checked);
+}
+
+void Dashboard::RunTriggered()
+{
+    // the run clock has already been started (backdated to the crossing)
+    if (run_in_progress) return;
+    BeginRun();
+    SaveCheckpoint();
+}
+
+void Dashboard::BeginRun()
+{
+    // starting by hand disarms the trigger
+    if (arm_button->isChecked())
+    {
+        arm_button->setChecked(false);
+    }
+
+    // start the run
+    start_button->setText("Stop Run");
+    run_status->setText("<font color='green'>Running</font>");
+    for (int i = 0; i < NUMBER_OF_LAPS; i++)
+    {
+        lap_actual_time[i]->SetTime(0, 0, READOUT_IDLE);
+    }
+    run_in_progress = true;
+    current_lap = 0;
+    avgspeed_numerator = 0.0;
+    avgspeed_denominator = 0;
+    lap_start_ms = 0;
+    ref_distance = -1.0;
+    ref_delta->SetNumber(0, 1, READOUT_IDLE);
+    predicted_finish->SetTime(0, 0, READOUT_IDLE);
+    lap_trace.Clear();
+    track_map->ClearTrail();
+    for (int i = 0; i < NUMBER_OF_LAPS; i++)
+    {
+        lap_finish_ms[i] = 0;
+    }
+}
+
 void Dashboard::NextLap()
+{
+    // read the run clock right as the button goes down, rather than
+    // settling for the last tick (replays don't run the clock though)
+    RunClock *clock = RunClock::instance();
+    CompleteLap(clock->IsRunning() ? clock->Elapsed() : current_secs * 1000);
+}
+
+void Dashboard::LapCrossed(int ms)
+{
+    // the lap detector interpolated the moment we crossed the line
+    CompleteLap(ms);
+}
+
+void Dashboard::CompleteLap(int ms)
 {
     if (!run_in_progress) return;
 
     current_lap++;
 
+    // the lap just finished can be kept as the reference from the options
+    last_lap = lap_trace;
+    lap_trace.Clear();
+    lap_start_ms = ms;
+    ref_distance = -1.0;
+
     if (current_lap >= NUMBER_OF_LAPS)
     {
         // stop the run
@@ -225,21 +434,109 @@ void Dashboard::NextLap()
         emit StopRun();
     }
 
-    // calculate the delta time for this lap
-    int delta_secs = expected_lap_secs[current_lap - 1] - current_secs;
-    int delta_m = delta_secs / 60;
-    int delta_s = delta_secs % 60;
-    QString lap_time_str;
-    if (delta_secs < 0)
+    lap_finish_ms[current_lap - 1] = ms;
+    ShowLapSplit(current_lap - 1);
+    SaveCheckpoint();
+
+    emit LapCompleted(current_lap, ms);
+}
+
+void Dashboard::ShowLapSplit(int lap)
+{
+    // calculate the delta time for this lap, to the ms
+    int delta_ms = expected_lap_secs[lap] * 1000 - lap_finish_ms[lap];
+    if (delta_ms < 0)
     {
         // behind schedule!
-        delta_m *= -1;
-        delta_s *= -1;
-        lap_time_str = QString("<h2><font color='red'>+%1:%2</font></h2>").arg(delta_m).arg(delta_s, 2, 10, QChar('0'));
+        lap_actual_time[lap]->SetSplit(-delta_ms, '+', READOUT_BAD);
     }
     else
     {
-        lap_time_str = QString("<h2><font color='green'>-%1:%2</font></h2>").arg(delta_m).arg(delta_s, 2, 10, QChar('0'));
+        lap_actual_time[lap]->SetSplit(delta_ms, '-', READOUT_GOOD);
     }
-    lap_actual_time[current_lap - 1]->setText(lap_time_str);
+}
+
+void Dashboard::SaveCheckpoint()
+{
+    runstate_t state;
+    memset(&state, 0, sizeof(state));
+    state.running = run_in_progress;
+    state.current_lap = current_lap;
+    for (int i = 0; i < NUMBER_OF_LAPS; i++)
+    {
+        state.lap_ms[i] = lap_finish_ms[i];
+    }
+    state.lap_start_ms = lap_start_ms;
+    state.avgspeed_numerator = avgspeed_numerator;
+    state.avgspeed_denominator = avgspeed_denominator;
+    RunCheckpoint::SetOrigin(&state, RunClock::instance()->Origin());
+    checkpoint.Save(state);
+}
+
+void Dashboard::ResumeRun()
+{
+    runstate_t state;
+    if (!checkpoint.Load(&state) || !state.running) return;
+
+    // a run that should have been over long ago was abandoned, not cut short
+    qint64 origin = RunCheckpoint::LocalOrigin(state);
+    if (LatencyClock::Now() - origin > 2 * MAX_RUN_TIME_SECS * 1000000LL) return;
+
+    // pick the clock up where it was, then the laps and averages
+    RunClock::instance()->StartAt(origin);
+    BeginRun();
+    current_lap = qBound(0, (int)state.current_lap, NUMBER_OF_LAPS - 1);
+    for (int i = 0; i < current_lap; i++)
+    {
+        lap_finish_ms[i] = state.lap_ms[i];
+        ShowLapSplit(i);
+    }
+    lap_start_ms = state.lap_start_ms;
+    avgspeed_numerator = state.avgspeed_numerator;
+    avgspeed_denominator = state.avgspeed_denominator;
+    if (avgspeed_denominator != 0)
+    {
+        double avgspeed = avgspeed_numerator / (double)avgspeed_denominator;
+        davgspeed->SetNumber(qRound(avgspeed * 10.0), 1);
+    }
+    SaveCheckpoint();
+}
+
+void Dashboard::UpdatePace(const gpsstate_t &state)
+{
+    // the hint keeps a fix where the finish meets the start from
+    // matching the wrong end of the lap
+    reflocation_t where;
+    if (!reference.Locate(state.pos, ref_distance, &where)) return;
+    ref_distance = where.distance;
+
+    // ahead (negative) or behind (positive) the reference at this point
+    int delta_ms = (state.timestamp - lap_start_ms) - where.ms;
+    ref_delta->SetNumber(delta_ms / 100, 1, (delta_ms > 0) ? READOUT_BAD : READOUT_GOOD);
+
+    // finishing this lap and every lap after it at the reference pace
+    int laps_left = NUMBER_OF_LAPS - current_lap - 1;
+    int finish_ms = state.timestamp + (reference.LapMs() - where.ms) + laps_left * reference.LapMs();
+    predicted_finish->SetTime(finish_ms / 1000, 0,
+                              (finish_ms <= MAX_RUN_TIME_SECS * 1000) ? READOUT_GOOD : READOUT_BAD);
+}
+
+void Dashboard::SaveReferenceLap()
+{
+    if (last_lap.IsEmpty()) return;
+
+    last_lap.Save(REFLAP_FILENAME);
+    reference = last_lap;
+    reference.Prepare();
+    track_map->SetReference(reference);
+}
+
+void Dashboard::RpmPainted(int us)
+{
+    latency->Painted(LAT_RPM, us);
+}
+
+void Dashboard::SpeedPainted(int us)
+{
+    latency->Painted(LAT_SPEED, us);
 }
@@ -10,6 +10,16 @@
 #include "ucvtypes.h"
 #include "Options.h"
 #include "qneedleindicator.h"
+#include "DigitReadout.h"
+#include "KioskRenderer.h"
+#include "LatencyMonitor.h"
+#include "StatusChannel.h"
+#include "RunClock.h"
+#include "RunCheckpoint.h"
+#include "StripChart.h"
+#include "GGDiagram.h"
+#include "TrackMap.h"
+#include "ReferenceLap.h"
 
 // define the size of the touch screen
 #define SCREEN_WIDTH 800
@@ -41,32 +51,77 @@ public slots:
     // hardware interface
     void EcuUpdate(ecustate_t state);
     void GpsUpdate(gpsstate_t state);
+    void ImuUpdate(imustate_t state);
     void TmrUpdate(int ms);
 
     void OptionsButtonClicked();
+    void StartRunButtonPressed();
     void StartRunButtonClicked();
+    void ArmButtonToggled(bool checked);
+
+    // an armed run started itself
+    void RunTriggered();
 
     void NextLap();
+    void LapCrossed(int ms);
+
+    // keep the last completed lap as the track map's reference
+    void SaveReferenceLap();
+
+    // latency instrumentation
+    void RpmPainted(int us);
+    void SpeedPainted(int us);
 
 signals:
-    void StartRun();
+    void StartRun(qint64 origin_us);
     void StopRun();
+    void ArmRun(bool armed);
+    void LapCompleted(int lap, int ms);
+    void SetStartFinish();
 
 private:
     QLabel *lap_number[NUMBER_OF_LAPS], *lap_expected_time[NUMBER_OF_LAPS],
-           *lap_actual_time[NUMBER_OF_LAPS], *run_status;
-    QPushButton *start_button, *next_lap_button, *options_button;
+           *run_status, *ref_delta_label, *finish_label;
+    DigitReadout *lap_actual_time[NUMBER_OF_LAPS];
+    QPushButton *start_button, *arm_button, *next_lap_button, *options_button;
     QNeedleIndicator *atach, *aspeed;
-    QLabel *dtach, *dspeed, *davgspeed;
+    DigitReadout *dtach, *dspeed, *davgspeed;
+    DigitReadout *ref_delta, *predicted_finish;
+    StripChart *trends;
+    int trend_rpm, trend_speed, trend_lat_g;
+    GGDiagram *gg;
+    TrackMap *track_map;
 
     int current_lap;
     int current_secs;
     int expected_lap_secs[NUMBER_OF_LAPS];
+    int lap_finish_ms[NUMBER_OF_LAPS]; // run time each lap was completed at
     double avgspeed_numerator;
     int avgspeed_denominator;
     bool run_in_progress;
+    ReferenceLap lap_trace, last_lap, reference;
+    int lap_start_ms;
+    qint64 start_pressed; // when the start button went down (in us on LatencyClock)
+    double ref_distance; // where the last fix fell on the reference (in m), negative for not yet
+
+    RunCheckpoint checkpoint;
 
     Options *options;
+    LatencyMonitor *latency;
+    LatencyOverlay *latency_overlay;
+    StatusBanner *status_banner;
+
+#ifdef Q_OS_LINUX
+    KioskRenderer *kiosk;
+    KioskTouch *kiosk_touch;
+#endif
+
+    void BeginRun();
+    void CompleteLap(int ms);
+    void ShowLapSplit(int lap);
+    void SaveCheckpoint();
+    void ResumeRun();
+    void UpdatePace(const gpsstate_t &state);
 };
 
 #endif // DASHBOARD_H
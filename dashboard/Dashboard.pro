@@ -9,6 +9,30 @@ SOURCES += main.cpp \
     Dashboard.cpp \
     Hardware.cpp \
     Options.cpp \
+    LogReader.cpp \
+    LogReplay.cpp \
+    SensorParser.cpp \
+    UartCapture.cpp \
+    CaptureReplay.cpp \
+    LogCopyJob.cpp \
+    LogCatalog.cpp \
+    LogPyramid.cpp \
+    PaintStats.cpp \
+    DigitReadout.cpp \
+    KioskRenderer.cpp \
+    LatencyMonitor.cpp \
+    StatusChannel.cpp \
+    RunClock.cpp \
+    StripChart.cpp \
+    GGDiagram.cpp \
+    LocalProjection.cpp \
+    ReferenceLap.cpp \
+    TrackMap.cpp \
+    LapDetector.cpp \
+    RunTrigger.cpp \
+    FlightRecorder.cpp \
+    RunCheckpoint.cpp \
+    Supervisor.cpp \
     qneedleindicator.cpp
 HEADERS += TestHarness.h \
     ucvtypes.h \
@@ -17,6 +41,30 @@ HEADERS += TestHarness.h \
     Hardware.h \
     Options.h \
     main.h \
+    LogReader.h \
+    LogReplay.h \
+    SensorParser.h \
+    UartCapture.h \
+    CaptureReplay.h \
+    LogCopyJob.h \
+    LogCatalog.h \
+    LogPyramid.h \
+    PaintStats.h \
+    DigitReadout.h \
+    KioskRenderer.h \
+    LatencyMonitor.h \
+    StatusChannel.h \
+    RunClock.h \
+    StripChart.h \
+    GGDiagram.h \
+    LocalProjection.h \
+    ReferenceLap.h \
+    TrackMap.h \
+    LapDetector.h \
+    RunTrigger.h \
+    FlightRecorder.h \
+    RunCheckpoint.h \
+    Supervisor.h \
     qneedleindicator.h
 LIBS += -lws2_32
 
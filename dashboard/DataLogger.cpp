@@ -1,9 +1,25 @@
 #include "DataLogger.h"
+#include "LogCatalog.h"
+#include "LogPyramid.h"
+#include "LatencyMonitor.h"
+#include "RunClock.h"
 
 DataLogger::DataLogger()
 {
     logger_running = false;
     logfile = NULL;
+    stream = NULL;
+    last_ms = 0;
+    log_origin = 0;
+    summary = new LogSummary();
+    pyramid = new LogPyramid();
+    catalog_writer = new CatalogWriter(this);
+
+    // allocated once, idling only ever copies into it
+    pretrigger.resize(PRETRIGGER_RECORDS);
+    pretrigger_acquired.resize(PRETRIGGER_RECORDS);
+    pretrigger_next = 0;
+    pretrigger_count = 0;
 }
 
 DataLogger::~DataLogger()
@@ -11,91 +27,244 @@ DataLogger::~DataLogger()
     // don't delete me without flushing my data to disk!
     if (logger_running) LogStop();
 
+    // nor before the catalog has caught up
+    catalog_writer->wait();
+
     if (logfile != NULL)
     {
         delete logfile;
     }
+
+    delete summary;
+    delete pyramid;
 }
 
 void DataLogger::EcuUpdate(ecustate_t state)
 {
-    // discard it if the logger isn't running
-    if (!logger_running || stream == NULL) return;
+    logrecord_t record;
+    record.type = ECU_RECORD;
+    record.ecu = state;
+    Record(record);
+}
 
-    // output the record type
-    *stream << (quint8)ECU_RECORD;
+void DataLogger::GpsUpdate(gpsstate_t state)
+{
+    logrecord_t record;
+    record.type = GPS_RECORD;
+    record.gps = state;
+    Record(record);
+}
 
-    // output the state data
-    *stream << (qint32)state.timestamp;
-    *stream << (qint32)state.rpm;
-    *stream << state.spark_adv;
-    *stream << state.cranking;
-    *stream << state.map;
-    *stream << state.mat;
-    *stream << state.clt;
-    *stream << state.tps;
-    *stream << state.batt;
-    *stream << state.maf;
-    *stream << (qint32)state.tach_count;
+void DataLogger::ImuUpdate(imustate_t state)
+{
+    logrecord_t record;
+    record.type = IMU_RECORD;
+    record.imu = state;
+    Record(record);
 }
 
-void DataLogger::GpsUpdate(gpsstate_t state)
+void DataLogger::LtsUpdate(ltsstate_t state)
 {
-    // discard it if the logger isn't running
-    if (!logger_running || stream == NULL) return;
+    logrecord_t record;
+    record.type = LTS_RECORD;
+    record.lts = state;
+    Record(record);
+}
 
-    // output the record type
-    *stream << (quint8)GPS_RECORD;
+void DataLogger::LapUpdate(int lap, int ms)
+{
+    logrecord_t record;
+    record.type = LAP_RECORD;
+    record.lap.timestamp = ms;
+    record.lap.lap = lap;
+    Record(record);
+}
 
-    // output the state data
-    *stream << (qint32)state.timestamp;
-    *stream << (qint32)state.utc_hrs;
-    *stream << (qint32)state.utc_mins;
-    *stream << state.utc_secs;
-    *stream << (qint32)state.pos.lat_deg;
-    *stream << state.pos.lat_mins;
-    *stream << (qint8)state.pos.lat_dir;
-    *stream << (qint32)state.pos.long_deg;
-    *stream << state.pos.long_mins;
-    *stream << (qint8)state.pos.long_dir;
-    *stream << state.alt;
-    *stream << state.speed;
-    *stream << state.heading;
+void DataLogger::Record(const logrecord_t &record)
+{
+    if (logger_running && stream != NULL)
+    {
+        // until the run starts the hardware stamps everything 0, those
+        // are put on the log's own time line instead
+        if (record.type != LAP_RECORD && !RunClock::instance()->IsRunning())
+        {
+            logrecord_t stamped = record;
+            Stamp(&stamped, Acquired(record));
+            WriteRecord(stamped);
+            return;
+        }
+
+        WriteRecord(record);
+        return;
+    }
+
+    // a lap belongs to the run it was completed in, never the next one
+    if (record.type == LAP_RECORD) return;
+
+    // not logging, keep it in the ring (overwriting the oldest when full)
+    // along with when it was read
+    pretrigger[pretrigger_next] = record;
+    pretrigger_acquired[pretrigger_next] = Acquired(record);
+    pretrigger_next = (pretrigger_next + 1) % PRETRIGGER_RECORDS;
+    if (pretrigger_count < PRETRIGGER_RECORDS) pretrigger_count++;
 }
 
-void DataLogger::ImuUpdate(imustate_t state)
+qint64 DataLogger::Acquired(const logrecord_t &record)
 {
-    // discard it if the logger isn't running
-    if (!logger_running || stream == NULL) return;
+    // lights states and laps don't carry when they were read so they get
+    // the time they arrived
+    switch (record.type)
+    {
+    case ECU_RECORD:
+        return record.ecu.acquired;
+    case GPS_RECORD:
+        return record.gps.acquired;
+    case IMU_RECORD:
+        return record.imu.acquired;
+    default:
+        return LatencyClock::Now();
+    }
+}
 
+void DataLogger::Stamp(logrecord_t *record, qint64 acquired)
+{
+    // run time once the run has started, otherwise time since the log
+    // was started (negative for what came before it)
+    RunClock *clock = RunClock::instance();
+    if (clock->IsRunning())
+    {
+        record->ecu.timestamp = clock->ElapsedAt(acquired);
+    }
+    else
+    {
+        record->ecu.timestamp = (int)((acquired - log_origin) / 1000);
+    }
+}
+
+void DataLogger::WriteRecord(const logrecord_t &record)
+{
+    EncodeRecord(stream, record);
+
+    // keep the catalog entry and the overview up to date
+    switch (record.type)
+    {
+    case ECU_RECORD:
+        summary->AddRecord(ECU_RECORD, record.ecu.timestamp);
+        summary->AddRpm(record.ecu.rpm);
+        pyramid->AddEcu(record.ecu);
+        break;
+    case GPS_RECORD:
+        summary->AddRecord(GPS_RECORD, record.gps.timestamp);
+        pyramid->AddGps(record.gps);
+        break;
+    case IMU_RECORD:
+        summary->AddRecord(IMU_RECORD, record.imu.timestamp);
+        pyramid->AddImu(record.imu);
+        break;
+    case LTS_RECORD:
+        summary->AddRecord(LTS_RECORD, record.lts.timestamp);
+        break;
+    case LAP_RECORD:
+        summary->AddRecord(LAP_RECORD, record.lap.timestamp);
+        summary->AddLap(record.lap.lap);
+        break;
+    }
+}
+
+void DataLogger::EncodeRecord(QDataStream *stream, const logrecord_t &record)
+{
     // output the record type
-    *stream << (quint8)IMU_RECORD;
+    *stream << (quint8)record.type;
 
     // output the state data
-    *stream << (qint32)state.timestamp;
-    *stream << state.ax;
-    *stream << state.ay;
-    *stream << state.az;
-    *stream << state.gx;
-    *stream << state.gy;
-    *stream << state.gz;
+    switch (record.type)
+    {
+    case ECU_RECORD:
+    {
+        const ecustate_t &state = record.ecu;
+        *stream << (qint32)state.timestamp;
+        *stream << (qint32)state.rpm;
+        *stream << state.spark_adv;
+        *stream << state.cranking;
+        *stream << state.map;
+        *stream << state.mat;
+        *stream << state.clt;
+        *stream << state.tps;
+        *stream << state.batt;
+        *stream << state.maf;
+        *stream << (qint32)state.tach_count;
+        break;
+    }
+    case GPS_RECORD:
+    {
+        const gpsstate_t &state = record.gps;
+        *stream << (qint32)state.timestamp;
+        *stream << (qint32)state.utc_hrs;
+        *stream << (qint32)state.utc_mins;
+        *stream << state.utc_secs;
+        *stream << (qint32)state.pos.lat_deg;
+        *stream << state.pos.lat_mins;
+        *stream << (qint8)state.pos.lat_dir;
+        *stream << (qint32)state.pos.long_deg;
+        *stream << state.pos.long_mins;
+        *stream << (qint8)state.pos.long_dir;
+        *stream << state.alt;
+        *stream << state.speed;
+        *stream << state.heading;
+        break;
+    }
+    case IMU_RECORD:
+    {
+        const imustate_t &state = record.imu;
+        *stream << (qint32)state.timestamp;
+        *stream << state.ax;
+        *stream << state.ay;
+        *stream << state.az;
+        *stream << state.gx;
+        *stream << state.gy;
+        *stream << state.gz;
+        break;
+    }
+    case LTS_RECORD:
+    {
+        const ltsstate_t &state = record.lts;
+        *stream << (qint32)state.timestamp;
+        *stream << state.headlights;
+        *stream << state.brakelights;
+        *stream << state.left_turn;
+        *stream << state.right_turn;
+        *stream << state.hazards;
+        break;
+    }
+    case LAP_RECORD:
+        *stream << (qint32)record.lap.timestamp;
+        *stream << (qint32)record.lap.lap;
+        break;
+    }
 }
 
-void DataLogger::LtsUpdate(ltsstate_t state)
+void DataLogger::FlushPretrigger()
 {
-    // discard it if the logger isn't running
-    if (!logger_running || stream == NULL) return;
+    qint64 now = LatencyClock::Now();
 
-    // output the record type
-    *stream << (quint8)LTS_RECORD;
+    int first = (pretrigger_next - pretrigger_count + PRETRIGGER_RECORDS) % PRETRIGGER_RECORDS;
+    for (int n = 0; n < pretrigger_count; n++)
+    {
+        int i = (first + n) % PRETRIGGER_RECORDS;
+        logrecord_t record = pretrigger[i];
+        qint64 acquired = pretrigger_acquired[i];
 
-    // output the state data
-    *stream << (qint32)state.timestamp;
-    *stream << state.headlights;
-    *stream << state.brakelights;
-    *stream << state.left_turn;
-    *stream << state.right_turn;
-    *stream << state.hazards;
+        // drop the stale ones and put the rest on the log's time line
+        // (they were all stamped 0 while waiting, now they come out
+        // negative)
+        if (now - acquired > PRETRIGGER_SECS * 1000000LL) continue;
+        Stamp(&record, acquired);
+
+        WriteRecord(record);
+    }
+
+    pretrigger_next = 0;
+    pretrigger_count = 0;
 }
 
 void DataLogger::TmrUpdate(int ms)
@@ -105,6 +274,8 @@ void DataLogger::TmrUpdate(int ms)
     // discard it if the logger isn't running
     if (!logger_running) return;
 
+    last_ms = ms;
+
     // flush the data to disk every 10 ticks (10 seconds)
     counter++;
     if (counter > 9)
@@ -124,6 +295,7 @@ void DataLogger::LogStart()
     QString filename = now.toString("yyyy-MM-dd_hh-mm-ss");
     filename += ".ucv";
     QString filepath = directory.absoluteFilePath(filename);
+    logpath = filepath;
 
     // open the log file for writing
     logfile = new QFile(filepath);
@@ -133,6 +305,19 @@ void DataLogger::LogStart()
     stream = new QDataStream(logfile);
     stream->setVersion(QDataStream::Qt_4_5);
 
+    // start a fresh catalog entry and overview for this log
+    summary->Reset(filename);
+    pyramid->Clear();
+
+    // latency histograms cover exactly the logged run
+    LatencyMonitor::instance()->Clear();
+
+    // records are stamped against this until the run clock is going
+    log_origin = LatencyClock::Now();
+
+    // lead in with whatever happened just before the log was started
+    FlushPretrigger();
+
     // the logger is now running
     logger_running = true;
     emit LogStatusChanged(logger_running);
@@ -143,14 +328,58 @@ void DataLogger::LogStop()
     // can't stop it if it's not running
     if (!logger_running) return;
 
+    // how stale the displayed values were during this run
+    WriteLatency();
+
     // close the log file to flush it to disk
     logfile->close();
 
     // clean up the data stream
     delete stream;
     delete logfile;
+    stream = NULL;
+    logfile = NULL;
+
+    // store the overview beside the log so viewers never have to build it
+    pyramid->Finish();
+    pyramid->Save(LogPyramid::PathFor(logpath));
+    pyramid->Clear();
+
+    // add this log to the catalog so nobody has to read it to describe it
+    // (rewriting the catalog happens on the writer's thread)
+    summary->Stat(directory);
+    catalog_writer->Add(directory, *summary);
 
     // the logger is no longer running
     logger_running = false;
     emit LogStatusChanged(logger_running);
 }
+
+void DataLogger::WriteLatency()
+{
+    if (stream == NULL) return;
+
+    LatencyMonitor *monitor = LatencyMonitor::instance();
+    for (int c = 0; c < LAT_CHANNELS; c++)
+    {
+        for (int k = 0; k < LAT_KINDS; k++)
+        {
+            const LatencyHistogram &hist = monitor->Histogram(c, k);
+            if (hist.Count() == 0) continue;
+
+            // output the record type
+            *stream << (quint8)LAT_RECORD;
+
+            // output the histogram
+            *stream << (qint32)last_ms;
+            *stream << (qint8)c;
+            *stream << (qint8)k;
+            for (int i = 0; i < LATENCY_BUCKETS; i++)
+            {
+                *stream << (quint32)hist.Bucket(i);
+            }
+
+            summary->AddRecord(LAT_RECORD, last_ms);
+        }
+    }
+}
@@ -6,14 +6,34 @@
 #include <QFile>
 #include <QDataStream>
 #include <QDateTime>
+#include <QVector>
 
 #include "ucvtypes.h"
 
+class LogSummary;
+class LogPyramid;
+class CatalogWriter;
+
 // record types (single byte identifiers)
 #define ECU_RECORD 0x01
 #define GPS_RECORD 0x02
 #define IMU_RECORD 0x03
 #define LTS_RECORD 0x04
+#define LAP_RECORD 0x05
+#define LAT_RECORD 0x06
+
+// size in bytes of each record's payload (not counting the type byte)
+#define ECU_RECORD_SIZE 69
+#define GPS_RECORD_SIZE 70
+#define IMU_RECORD_SIZE 52
+#define LTS_RECORD_SIZE 9
+#define LAP_RECORD_SIZE 8
+#define LAT_RECORD_SIZE (4 + 1 + 1 + 4 * LATENCY_BUCKETS)
+
+// how far back (in secs) the records kept while the logger is stopped go,
+// and the most that are kept, they get written at the top of the next log
+#define PRETRIGGER_SECS 10
+#define PRETRIGGER_RECORDS 4096
 
 class DataLogger : public QObject
 {
@@ -25,6 +45,12 @@ public:
 
     void SetDirectory(QDir dir) { directory = dir; }
 
+    // the type byte and payload of one record, as they appear in a log
+    static void EncodeRecord(QDataStream *stream, const logrecord_t &record);
+
+    // when a record's data was read (in us on LatencyClock)
+    static qint64 Acquired(const logrecord_t &record);
+
 public slots:
     // hardware interface
     void EcuUpdate(ecustate_t state);
@@ -33,6 +59,9 @@ public slots:
     void LtsUpdate(ltsstate_t state);
     void TmrUpdate(int ms);
 
+    // dashboard interface
+    void LapUpdate(int lap, int ms);
+
     // control interface
     void LogStart();
     void LogStop();
@@ -45,6 +74,25 @@ private:
     QDir directory;
     QFile *logfile;
     QDataStream *stream;
+    LogSummary *summary; // catalog entry for the log being written
+    CatalogWriter *catalog_writer;
+    LogPyramid *pyramid; // overview of the log being written
+    QString logpath;
+    int last_ms; // latest timer tick, stamps the records written at the end
+    qint64 log_origin; // when the log was started (in us on LatencyClock)
+
+    // while stopped every record goes into this ring instead, so a log
+    // starts with the crank and launch that happened just before it
+    QVector<logrecord_t> pretrigger;
+    QVector<qint64> pretrigger_acquired; // in us on LatencyClock, for every record type
+    int pretrigger_next;
+    int pretrigger_count;
+
+    void Record(const logrecord_t &record);
+    void Stamp(logrecord_t *record, qint64 acquired);
+    void WriteRecord(const logrecord_t &record);
+    void FlushPretrigger();
+    void WriteLatency();
 };
 
 #endif // DATALOGGER_H
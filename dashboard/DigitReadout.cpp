@@ -0,0 +1,260 @@
+#include "DigitReadout.h"
+
+#include <cstring>
+
+static const char glyphs[] = READOUT_GLYPHS;
+
+DigitReadout::DigitReadout(QWidget *parent)
+    : QWidget(parent)
+{
+    length = 0;
+    text[0] = '\0';
+    state = READOUT_NORMAL;
+    origin_x = 0;
+    hint_chars = 6;
+    cell_width = 0;
+    cell_height = 0;
+    ascent = 0;
+
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    BuildAtlas();
+}
+
+QColor DigitReadout::StateColor(readout_state_t state)
+{
+    switch (state)
+    {
+    case READOUT_GOOD:
+        return QColor(0, 128, 0);
+    case READOUT_BAD:
+        return Qt::red;
+    case READOUT_IDLE:
+        return Qt::gray;
+    default:
+        return Qt::black;
+    }
+}
+
+void DigitReadout::BuildAtlas()
+{
+    // every glyph gets the same cell width so a changed character only
+    // ever dirties its own cell
+    QFontMetrics metrics(font());
+    int glyph_count = sizeof(glyphs) - 1;
+    cell_width = 0;
+    for (int i = 0; i < glyph_count; i++)
+    {
+        cell_width = qMax(cell_width, metrics.width(QChar(glyphs[i])));
+    }
+    cell_height = metrics.height();
+    ascent = metrics.ascent();
+
+    QColor background = palette().color(QPalette::Window);
+    atlas = QPixmap(cell_width * glyph_count, cell_height * READOUT_STATES);
+    atlas.fill(background);
+    QPainter painter(&atlas);
+    painter.setFont(font());
+    for (int s = 0; s < READOUT_STATES; s++)
+    {
+        painter.setPen(StateColor((readout_state_t)s));
+        for (int i = 0; i < glyph_count; i++)
+        {
+            QRect cell(i * cell_width, s * cell_height, cell_width, cell_height);
+            painter.drawText(cell, Qt::AlignCenter, QString(QChar(glyphs[i])));
+        }
+    }
+    painter.end();
+
+    // the suffix never changes, so it's just one more prerendered piece
+    int suffix_width = qMax(metrics.width(suffix), 1);
+    for (int s = 0; s < READOUT_STATES; s++)
+    {
+        suffix_pixmaps[s] = QPixmap(suffix_width, cell_height);
+        suffix_pixmaps[s].fill(background);
+        QPainter suffix_painter(&suffix_pixmaps[s]);
+        suffix_painter.setFont(font());
+        suffix_painter.setPen(StateColor((readout_state_t)s));
+        suffix_painter.drawText(0, ascent, suffix);
+    }
+
+    Layout();
+    updateGeometry();
+    update();
+}
+
+void DigitReadout::SetSuffix(QString new_suffix)
+{
+    suffix = new_suffix;
+    BuildAtlas();
+}
+
+void DigitReadout::SetNumber(int value, int decimals, readout_state_t new_state)
+{
+    // format right to left into a local buffer, no QString involved
+    char buffer[READOUT_MAX_CHARS];
+    int pos = READOUT_MAX_CHARS;
+    bool negative = (value < 0);
+    unsigned int magnitude = negative ? -(unsigned int)value : (unsigned int)value;
+
+    int digits = 0;
+    do
+    {
+        buffer[--pos] = '0' + (magnitude % 10);
+        magnitude /= 10;
+        digits++;
+        if (digits == decimals && pos > 0) buffer[--pos] = '.';
+    } while ((magnitude > 0 || digits <= decimals) && pos > 1);
+    if (negative) buffer[--pos] = '-';
+
+    Show(buffer + pos, READOUT_MAX_CHARS - pos, new_state);
+}
+
+void DigitReadout::SetTime(int secs, char sign, readout_state_t new_state)
+{
+    char buffer[READOUT_MAX_CHARS];
+    int pos = READOUT_MAX_CHARS;
+    if (secs < 0) secs = -secs;
+    int mins = secs / 60;
+    secs %= 60;
+
+    buffer[--pos] = '0' + secs % 10;
+    buffer[--pos] = '0' + secs / 10;
+    buffer[--pos] = ':';
+    do
+    {
+        buffer[--pos] = '0' + mins % 10;
+        mins /= 10;
+    } while (mins > 0 && pos > 1);
+    if (sign) buffer[--pos] = sign;
+
+    Show(buffer + pos, READOUT_MAX_CHARS - pos, new_state);
+}
+
+void DigitReadout::SetHintChars(int chars)
+{
+    hint_chars = qBound(1, chars, READOUT_MAX_CHARS);
+    updateGeometry();
+}
+
+void DigitReadout::SetSplit(int ms, char sign, readout_state_t new_state)
+{
+    char buffer[READOUT_MAX_CHARS];
+    int pos = READOUT_MAX_CHARS;
+    if (ms < 0) ms = -ms;
+    int secs = ms / 1000;
+    ms %= 1000;
+    int mins = secs / 60;
+    secs %= 60;
+
+    buffer[--pos] = '0' + ms % 10;
+    buffer[--pos] = '0' + (ms / 10) % 10;
+    buffer[--pos] = '0' + ms / 100;
+    buffer[--pos] = '.';
+    buffer[--pos] = '0' + secs % 10;
+    buffer[--pos] = '0' + secs / 10;
+    buffer[--pos] = ':';
+    do
+    {
+        buffer[--pos] = '0' + mins % 10;
+        mins /= 10;
+    } while (mins > 0 && pos > 1);
+    if (sign) buffer[--pos] = sign;
+
+    Show(buffer + pos, READOUT_MAX_CHARS - pos, new_state);
+}
+
+void DigitReadout::SetState(readout_state_t new_state)
+{
+    Show(text, length, new_state);
+}
+
+void DigitReadout::Show(const char *new_text, int new_length, readout_state_t new_state)
+{
+    if (new_state != state || new_length != length)
+    {
+        // the color or the centering changed, so everything moves
+        memmove(text, new_text, new_length);
+        text[new_length] = '\0';
+        length = new_length;
+        state = new_state;
+        Layout();
+        update();
+        return;
+    }
+
+    // same layout; repaint only the cells whose character changed
+    for (int i = 0; i < length; i++)
+    {
+        if (text[i] != new_text[i])
+        {
+            text[i] = new_text[i];
+            update(CellRect(i));
+        }
+    }
+}
+
+int DigitReadout::TextWidth(int chars) const
+{
+    return chars * cell_width + (suffix.isEmpty() ? 0 : suffix_pixmaps[0].width());
+}
+
+void DigitReadout::Layout()
+{
+    origin_x = (width() - TextWidth(length)) / 2;
+}
+
+QRect DigitReadout::CellRect(int index) const
+{
+    int y = (height() - cell_height) / 2;
+    return QRect(origin_x + index * cell_width, y, cell_width, cell_height);
+}
+
+QSize DigitReadout::sizeHint() const
+{
+    // room for a typical reading, e.g. "8000" or "+12:34" by default
+    return QSize(TextWidth(hint_chars) + 4, cell_height + 4);
+}
+
+void DigitReadout::paintEvent(QPaintEvent *event)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QPainter painter(this);
+    painter.fillRect(event->rect(), palette().color(QPalette::Window));
+
+    for (int i = 0; i < length; i++)
+    {
+        QRect cell = CellRect(i);
+        if (!event->rect().intersects(cell)) continue;
+
+        const char *glyph = strchr(glyphs, text[i]);
+        int index = glyph ? (int)(glyph - glyphs) : (int)sizeof(glyphs) - 2; // unknown shows blank
+        painter.drawPixmap(cell.topLeft(), atlas,
+                           QRect(index * cell_width, state * cell_height, cell_width, cell_height));
+    }
+
+    if (!suffix.isEmpty())
+    {
+        QRect cell = CellRect(length);
+        painter.drawPixmap(cell.topLeft(), suffix_pixmaps[state]);
+    }
+    painter.end();
+
+    emit Painted((int)(timer.nsecsElapsed() / 1000));
+}
+
+void DigitReadout::resizeEvent(QResizeEvent *event)
+{
+    Layout();
+    QWidget::resizeEvent(event);
+}
+
+void DigitReadout::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::FontChange || event->type() == QEvent::PaletteChange)
+    {
+        BuildAtlas();
+    }
+    QWidget::changeEvent(event);
+}
@@ -0,0 +1,93 @@
+#ifndef DIGITREADOUT_H
+#define DIGITREADOUT_H
+
+#include <QWidget>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPixmap>
+#include <QString>
+#include <QColor>
+#include <QFont>
+#include <QFontMetrics>
+#include <QEvent>
+#include <QElapsedTimer>
+
+// the characters a readout can show, in atlas order
+#define READOUT_GLYPHS "0123456789.:+- "
+
+// longest text a readout can show (not counting the suffix)
+#define READOUT_MAX_CHARS 12
+
+// color states of a readout
+typedef enum {
+    READOUT_NORMAL = 0, // black
+    READOUT_GOOD, // green, on target
+    READOUT_BAD, // red, behind schedule
+    READOUT_IDLE, // grey, nothing to show yet
+    READOUT_STATES
+} readout_state_t;
+
+// numeric display that draws its digits out of a glyph atlas rendered
+// once per font, rather than laying out rich text on every update
+// updates only format into a fixed buffer and repaint the character cells
+// that actually changed, so nothing is allocated after construction
+class DigitReadout : public QWidget
+{
+    Q_OBJECT
+
+public:
+    DigitReadout(QWidget *parent = 0);
+
+    // fixed text after the number (e.g. " rpm"), drawn in the atlas font
+    void SetSuffix(QString text);
+
+    // value is fixed point with the given number of decimals,
+    // e.g. SetNumber(354, 1) shows 35.4
+    void SetNumber(int value, int decimals = 0, readout_state_t state = READOUT_NORMAL);
+
+    // m:ss, with an optional leading sign character ('+' or '-', 0 for none)
+    void SetTime(int secs, char sign = 0, readout_state_t state = READOUT_NORMAL);
+
+    // m:ss.mmm, for lap splits
+    void SetSplit(int ms, char sign = 0, readout_state_t state = READOUT_NORMAL);
+
+    void SetState(readout_state_t state);
+
+    // how many characters the size hint leaves room for
+    void SetHintChars(int chars);
+
+    virtual QSize sizeHint() const;
+    virtual QSize minimumSizeHint() const { return sizeHint(); }
+
+signals:
+    // after every repaint, with the time spent painting (in us)
+    void Painted(int us);
+
+protected:
+    virtual void paintEvent(QPaintEvent *event);
+    virtual void resizeEvent(QResizeEvent *event);
+    virtual void changeEvent(QEvent *event);
+
+private:
+    QPixmap atlas; // one row of glyph cells per color state
+    QPixmap suffix_pixmaps[READOUT_STATES];
+    QString suffix;
+    int cell_width;
+    int cell_height;
+    int ascent;
+
+    char text[READOUT_MAX_CHARS + 1];
+    int length;
+    readout_state_t state;
+    int origin_x; // left edge of the first character cell
+    int hint_chars;
+
+    void BuildAtlas();
+    void Show(const char *new_text, int new_length, readout_state_t new_state);
+    int TextWidth(int chars) const;
+    void Layout();
+    QRect CellRect(int index) const;
+    static QColor StateColor(readout_state_t state);
+};
+
+#endif // DIGITREADOUT_H
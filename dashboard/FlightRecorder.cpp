@@ -0,0 +1,224 @@
+#include "FlightRecorder.h"
+#include "DataLogger.h"
+#include "LatencyMonitor.h"
+
+#include <cstring>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+#endif
+
+FlightRecorder::FlightRecorder(QObject *parent)
+    : QObject(parent)
+{
+    map = NULL;
+    map_size = 0;
+    header = NULL;
+    ring = NULL;
+    seq = 0;
+    system_offset = LatencyClock::SystemOffset();
+    recovered_count = 0;
+
+    sync_timer.setInterval(FLIGHT_SYNC_MS);
+    connect(&sync_timer, SIGNAL(timeout()), this, SLOT(Sync()));
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    Close();
+}
+
+bool FlightRecorder::Open(QString filepath, QDir recovery_dir)
+{
+    Close();
+
+    map_size = FLIGHT_HEADER_SIZE + (qint64)FLIGHT_SLOTS * sizeof(flightslot_t);
+    file.setFileName(filepath);
+    if (!file.open(QIODevice::ReadWrite)) return false;
+    if (file.size() != map_size && !file.resize(map_size))
+    {
+        file.close();
+        return false;
+    }
+
+    map = file.map(0, map_size);
+    if (map == NULL)
+    {
+        file.close();
+        return false;
+    }
+    header = (flightheader_t *)map;
+    ring = (flightslot_t *)(map + FLIGHT_HEADER_SIZE);
+
+    // a file this build wrote and never closed holds the end of a
+    // session that crashed or lost power
+    recovered_path.clear();
+    recovered_count = 0;
+    bool ours = (header->magic == FLIGHT_MAGIC &&
+                 header->slot_size == sizeof(flightslot_t) &&
+                 header->slot_count == FLIGHT_SLOTS);
+    if (ours && header->open)
+    {
+        recovered_count = Recover(recovery_dir);
+    }
+
+    // start over with an empty ring
+    memset(map, 0, map_size);
+    header->magic = FLIGHT_MAGIC;
+    header->slot_size = sizeof(flightslot_t);
+    header->slot_count = FLIGHT_SLOTS;
+    header->open = 1;
+    header->seq = 0;
+    seq = 0;
+
+    Sync();
+    sync_timer.start();
+    return true;
+}
+
+void FlightRecorder::Close()
+{
+    if (map == NULL) return;
+
+    sync_timer.stop();
+
+    // a clean shutdown leaves nothing to recover
+    header->open = 0;
+    Sync();
+    file.unmap(map);
+    file.close();
+
+    map = NULL;
+    header = NULL;
+    ring = NULL;
+}
+
+void FlightRecorder::EcuUpdate(ecustate_t state)
+{
+    logrecord_t record;
+    record.type = ECU_RECORD;
+    record.ecu = state;
+    Record(record);
+}
+
+void FlightRecorder::GpsUpdate(gpsstate_t state)
+{
+    logrecord_t record;
+    record.type = GPS_RECORD;
+    record.gps = state;
+    Record(record);
+}
+
+void FlightRecorder::ImuUpdate(imustate_t state)
+{
+    logrecord_t record;
+    record.type = IMU_RECORD;
+    record.imu = state;
+    Record(record);
+}
+
+void FlightRecorder::LtsUpdate(ltsstate_t state)
+{
+    logrecord_t record;
+    record.type = LTS_RECORD;
+    record.lts = state;
+    Record(record);
+}
+
+void FlightRecorder::LapUpdate(int lap, int ms)
+{
+    logrecord_t record;
+    record.type = LAP_RECORD;
+    record.lap.timestamp = ms;
+    record.lap.lap = lap;
+    Record(record);
+}
+
+void FlightRecorder::Record(const logrecord_t &record)
+{
+    if (ring == NULL) return;
+
+    // 0 marks an empty slot, so it's never used as a sequence number
+    seq++;
+    if (seq <= 0) seq = 1;
+    flightslot_t *slot = &ring[seq % FLIGHT_SLOTS];
+
+    // clear the slot's number before touching the record and publish the
+    // new one after it, so a slot is either whole or plainly unfinished
+    ((QAtomicInt *)&slot->seq)->fetchAndStoreRelease(0);
+    // (checksummed from the slot's copy so padding bytes match on recovery)
+    slot->acquired = DataLogger::Acquired(record) + system_offset;
+    memcpy(&slot->record, &record, sizeof(record));
+    slot->check = Checksum(*slot);
+    ((QAtomicInt *)&slot->seq)->fetchAndStoreRelease(seq);
+    ((QAtomicInt *)&header->seq)->fetchAndStoreRelease(seq);
+}
+
+void FlightRecorder::Sync()
+{
+    if (map == NULL) return;
+
+    // ask for the dirty pages to be written back, without waiting on it
+#ifdef Q_OS_WIN
+    FlushViewOfFile(map, 0);
+#else
+    msync(map, map_size, MS_ASYNC);
+#endif
+}
+
+int FlightRecorder::Recover(QDir dir)
+{
+    // every whole slot, in the order it was written
+    QVector<qint64> order;
+    order.reserve(FLIGHT_SLOTS);
+    for (int i = 0; i < FLIGHT_SLOTS; i++)
+    {
+        const flightslot_t &slot = ring[i];
+        if (slot.seq <= 0 || slot.check != Checksum(slot)) continue;
+        order.append(((qint64)slot.seq << 32) | i);
+    }
+    if (order.isEmpty()) return 0;
+    std::sort(order.begin(), order.end());
+
+    QString filename = QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss");
+    filename += "_recovered.ucv";
+    QFile out(dir.absoluteFilePath(filename));
+    if (!out.open(QIODevice::WriteOnly)) return 0;
+
+    QDataStream stream(&out);
+    stream.setVersion(QDataStream::Qt_4_5);
+    // restamped in ms from the first record kept, so the runs (and the
+    // idling between them) follow on from each other
+    qint64 origin = ring[order[0] & 0xffffffff].acquired;
+    for (int n = 0; n < order.size(); n++)
+    {
+        const flightslot_t &slot = ring[order[n] & 0xffffffff];
+        logrecord_t record = slot.record;
+        record.ecu.timestamp = (int)((slot.acquired - origin) / 1000);
+        DataLogger::EncodeRecord(&stream, record);
+    }
+    out.close();
+
+    recovered_path = out.fileName();
+    return order.size();
+}
+
+quint32 FlightRecorder::Checksum(const flightslot_t &slot)
+{
+    // fnv-1a over everything in the slot after the checksum itself
+    quint32 hash = 2166136261u;
+    const uchar *bytes = (const uchar *)&slot.seq;
+    for (unsigned int i = 0; i < sizeof(slot.seq); i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    bytes = (const uchar *)&slot.acquired;
+    for (unsigned int i = 0; i < sizeof(slot.acquired) + sizeof(slot.record); i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
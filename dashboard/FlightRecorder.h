@@ -0,0 +1,97 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <QObject>
+#include <QFile>
+#include <QDir>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include <QDataStream>
+#include <QAtomicInt>
+#include <QDateTime>
+
+#include "ucvtypes.h"
+
+// identifies (and versions) the flight recorder file format
+#define FLIGHT_MAGIC 0x55434632 // "UCF2"
+
+// where the flight recorder lives, next to the logs
+#define FLIGHT_FILENAME "flight.rec"
+
+// number of records the ring holds, about 5 minutes at full sensor rate
+#define FLIGHT_SLOTS 65536
+
+// the header gets a page to itself so the slots start page aligned
+#define FLIGHT_HEADER_SIZE 4096
+
+// how often (in ms) the mapping is handed to the os to write back
+#define FLIGHT_SYNC_MS 1000
+
+typedef struct flightheader_struct {
+    quint32 magic;
+    quint32 slot_size; // sizeof(flightslot_t) of the build that wrote it
+    quint32 slot_count;
+    qint32 open; // nonzero while a recorder has it, so still set after a crash
+    qint32 seq; // last sequence number written
+} flightheader_t;
+
+typedef struct flightslot_struct {
+    qint32 seq; // 0 while empty or being written
+    quint32 check; // over the rest of the slot, catches slots torn by a power cut
+    qint64 acquired; // on the system wide monotonic clock (in us), see LatencyClock::SystemOffset
+    logrecord_t record;
+} flightslot_t;
+
+// always-on ring of every decoded record in a memory mapped file
+// recording is a copy into the mapping bracketed by release stores of the
+// slot's sequence number, no system calls, the os writes the pages back on
+// its own (nudged once a second) whatever the data logger is doing
+// on the next start a file that was never closed is recovered into a
+// normal log of the slots in sequence order before recording starts over,
+// stamped by when each was acquired (the run clock restarts with every
+// run so the records' own timestamps can't be put in order)
+class FlightRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    FlightRecorder(QObject *parent = 0);
+    ~FlightRecorder();
+
+    // recovers what a crashed session left into recovery_dir first
+    bool Open(QString filepath, QDir recovery_dir);
+    void Close();
+
+    // the log recovered by Open, empty if there was nothing to recover
+    QString RecoveredPath() const { return recovered_path; }
+    int RecoveredCount() const { return recovered_count; }
+
+public slots:
+    void EcuUpdate(ecustate_t state);
+    void GpsUpdate(gpsstate_t state);
+    void ImuUpdate(imustate_t state);
+    void LtsUpdate(ltsstate_t state);
+    void LapUpdate(int lap, int ms);
+
+private slots:
+    void Sync();
+
+private:
+    QFile file;
+    uchar *map;
+    qint64 map_size;
+    flightheader_t *header;
+    flightslot_t *ring;
+    int seq;
+    qint64 system_offset; // LatencyClock to the system wide clock (in us)
+    QTimer sync_timer;
+    QString recovered_path;
+    int recovered_count;
+
+    void Record(const logrecord_t &record);
+    int Recover(QDir dir);
+    static quint32 Checksum(const flightslot_t &slot);
+};
+
+#endif // FLIGHTRECORDER_H
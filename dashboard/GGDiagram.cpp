@@ -0,0 +1,139 @@
+#include "GGDiagram.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define GG_USE_SSE2
+#endif
+
+GGDiagram::GGDiagram(QWidget *parent)
+    : QWidget(parent)
+{
+    stride = 0;
+    side = 0;
+    lit = false;
+    last_x = 0.0;
+    last_y = 0.0;
+
+    // intensity ramps from the background to a dark blue
+    colors.resize(256);
+    for (int i = 0; i < 256; i++)
+    {
+        colors[i] = qRgb(255 - i, 255 - i * 3 / 4, 255 - i / 4);
+    }
+
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
+
+    timer = new QTimer(this);
+    timer->setInterval(GG_FADE_MS);
+    connect(timer, SIGNAL(timeout()), this, SLOT(Fade()));
+}
+
+void GGDiagram::resizeEvent(QResizeEvent *event)
+{
+    // square, rows padded so the fade can always work 16 bytes at a time
+    side = qMax(qMin(width(), height()), 1);
+    stride = (side + 15) & ~15;
+    buffer.fill(0, stride * side);
+    image = QImage(buffer.data(), side, side, stride, QImage::Format_Indexed8);
+    image.setColorTable(colors);
+    lit = false;
+
+    QWidget::resizeEvent(event);
+}
+
+void GGDiagram::Clear()
+{
+    buffer.fill(0);
+    lit = false;
+    update();
+}
+
+void GGDiagram::ImuUpdate(imustate_t state)
+{
+    if (side <= 1) return;
+
+    // x is lateral (driver right is positive), y is longitudinal with
+    // braking (car z positive, backward) drawn towards the top
+    last_x = state.ax;
+    last_y = state.az;
+    double scale = (side / 2 - 1) / GG_MAX_G;
+    int px = side / 2 + (int)(last_x * scale);
+    int py = side / 2 - (int)(last_y * scale);
+    px = qBound(0, px, side - 1);
+    py = qBound(0, py, side - 1);
+
+    uchar &cell = buffer[py * stride + px];
+    cell = (uchar)qMin((int)cell + GG_HIT, 255);
+
+    if (!lit)
+    {
+        lit = true;
+        timer->start();
+    }
+    update();
+}
+
+void GGDiagram::Fade()
+{
+    uchar *data = buffer.data();
+    int size = buffer.size();
+
+    // one saturating subtract over the whole buffer, points fade away
+    // without ever being drawn again
+    bool any = false;
+#ifdef GG_USE_SSE2
+    const __m128i step = _mm_set1_epi8(GG_FADE_STEP);
+    __m128i seen = _mm_setzero_si128();
+    for (int i = 0; i < size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        v = _mm_subs_epu8(v, step);
+        _mm_storeu_si128((__m128i *)(data + i), v);
+        seen = _mm_or_si128(seen, v);
+    }
+    any = _mm_movemask_epi8(_mm_cmpeq_epi8(seen, _mm_setzero_si128())) != 0xffff;
+#else
+    for (int i = 0; i < size; i++)
+    {
+        int v = data[i] - GG_FADE_STEP;
+        data[i] = (uchar)(v > 0 ? v : 0);
+        any |= (v > 0);
+    }
+#endif
+
+    // everything has faded out, stop waking up until the next sample
+    if (!any)
+    {
+        lit = false;
+        timer->stop();
+    }
+    update();
+}
+
+void GGDiagram::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+
+    int x0 = (width() - side) / 2;
+    int y0 = (height() - side) / 2;
+    painter.drawImage(x0, y0, image);
+
+    // friction circles at half and full scale plus the axes
+    int c = side / 2;
+    int r = side / 2 - 1;
+    painter.setPen(Qt::lightGray);
+    painter.drawLine(x0, y0 + c, x0 + side - 1, y0 + c);
+    painter.drawLine(x0 + c, y0, x0 + c, y0 + side - 1);
+    painter.drawEllipse(QPoint(x0 + c, y0 + c), r / 2, r / 2);
+    painter.setPen(Qt::gray);
+    painter.drawEllipse(QPoint(x0 + c, y0 + c), r, r);
+
+    // where the car is right now
+    double scale = r / GG_MAX_G;
+    QPoint now(x0 + c + (int)(last_x * scale), y0 + c - (int)(last_y * scale));
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(Qt::red);
+    painter.drawEllipse(now, 3, 3);
+}
@@ -0,0 +1,60 @@
+#ifndef GGDIAGRAM_H
+#define GGDIAGRAM_H
+
+#include <QWidget>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QImage>
+#include <QVector>
+#include <QRgb>
+#include <QTimer>
+
+#include "ucvtypes.h"
+
+// acceleration at the edge of the diagram (in g's)
+#define GG_MAX_G 1.0
+
+// how often the point cloud fades, and by how much (out of 255)
+#define GG_FADE_MS 50
+#define GG_FADE_STEP 3
+
+// intensity added by each sample, saturating at 255
+#define GG_HIT 96
+
+// friction circle of lateral vs longitudinal acceleration
+// samples land in an 8 bit intensity buffer that is faded as a whole with
+// one (SIMD where available) saturating subtract, so the cost of a frame
+// doesn't depend on how many samples have been plotted
+class GGDiagram : public QWidget
+{
+    Q_OBJECT
+
+public:
+    GGDiagram(QWidget *parent = 0);
+
+    virtual QSize sizeHint() const { return QSize(120, 120); }
+
+public slots:
+    void ImuUpdate(imustate_t state);
+    void Clear();
+
+protected:
+    virtual void paintEvent(QPaintEvent *event);
+    virtual void resizeEvent(QResizeEvent *event);
+
+private slots:
+    void Fade();
+
+private:
+    QVector<uchar> buffer; // intensity, padded to a multiple of 16 bytes per row
+    QImage image; // 8 bit indexed view onto the buffer, no copy
+    QVector<QRgb> colors;
+    int stride;
+    int side;
+    bool lit; // anything left to fade
+    QTimer *timer;
+    double last_x, last_y; // latest sample (in g's)
+};
+
+#endif // GGDIAGRAM_H
@@ -3,10 +3,8 @@
 
 #include <QObject>
 #include <QApplication>
-#include <QTime>
 #include <QTimer>
 #include <QByteArray>
-#include <QMessageBox>
 #include <QRegExp>
 
 #ifdef RUNNING_IN_CAR
@@ -16,6 +14,13 @@
 
 #include "DataLogger.h"
 #include "Dashboard.h"
+#include "SensorParser.h"
+#include "UartCapture.h"
+#include "LapDetector.h"
+#include "RunClock.h"
+#include "RunTrigger.h"
+#include "FlightRecorder.h"
+#include "StatusChannel.h"
 #include "ucvtypes.h"
 
 // com port settings
@@ -25,26 +30,21 @@
 #define XBEE_COM_PORT L"COM5"
 #define DRVR_COM_PORT L"COM6"
 
-// default imu calibration
-#define IMU_DEFAULT_AX 512
-#define IMU_DEFAULT_AY 512
-#define IMU_DEFAULT_AZ 512
-#define IMU_DEFAULT_GX 512
-#define IMU_DEFAULT_GY 512
-#define IMU_DEFAULT_GZ 512
-
-// g's and degrees per second per dac step
-// this is based on 1024 values (10-bit DAC)
-// and +/- 3g range and +/- 300 deg/sec range
-#define GS_PER_STEP 0.005859375
-#define DPS_PER_STEP 0.5859375
-
 // the number of attempts to make to read all
 // 112 bytes from the ECU before aborting
 // this prevents the dashboard from hanging if the
 // ECU refuses to respond with data
 #define ECU_MAX_ATTEMPTS 3
 
+// read/write failures in a row before a com port is given up on and
+// reopened, anything less is cleared and polled again
+#define UART_MAX_FAILURES 3
+
+// wait before reopening a com port (in ms), doubled after every attempt
+// that fails up to the max
+#define UART_REOPEN_MS 500
+#define UART_MAX_REOPEN_MS 8000
+
 class Hardware : public QObject
 {
     Q_OBJECT
@@ -55,9 +55,12 @@ public:
 
 public slots:
     void WlsDataSend(QByteArray data);
-    void TmrStart();
+    void TmrStart(qint64 origin_us);
     void TmrStop();
+    void RunTriggered(qint64 origin_us);
     void TimerTick();
+    void GpsLockChanged(bool locked);
+    void ImuZeroed();
 
 signals:
     void EcuStateChanged(ecustate_t state);
@@ -68,22 +71,30 @@ signals:
     void WlsDataArrived(QByteArray data);
 
 private:
-    bool timer_running;
-    int last_elapsed;
-    QTime *time;
+    RunClock *clock;
     QTimer *timer;
     DataLogger *logger;
     Dashboard *dashboard;
+    SensorParser *parser;
+    UartCapture *capture;
+    LapDetector *lap_detector;
+    RunTrigger *trigger;
+    FlightRecorder *recorder;
 
 #ifdef RUNNING_IN_CAR
-    HANDLE hEcuUart;
-    HANDLE hGpsUart;
-    HANDLE hImuUart;
-    HANDLE hXbeeUart;
-    HANDLE hDrvrUart;
+    // indexed by status source (ecu, gps, imu, xbee, driver),
+    // INVALID_HANDLE_VALUE while a port is waiting to be reopened
+    HANDLE uarts[STATUS_SOURCES];
+    int failures[STATUS_SOURCES];
+    int reopen_ms[STATUS_SOURCES];
+    qint64 reopen_due[STATUS_SOURCES]; // in us on LatencyClock
 
     void OpenUarts();
     void CloseUarts();
+    bool OpenUart(int port);
+    void UartError(int port, const char *text);
+    void ScheduleReopen(int port);
+    void ReopenUarts();
     void ProcessEcu();
     void ProcessGps();
     void ProcessImu();
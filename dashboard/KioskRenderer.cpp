@@ -0,0 +1,432 @@
+#include "KioskRenderer.h"
+
+#ifdef Q_OS_LINUX
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/ioctl.h>
+    #include <linux/fb.h>
+    #include <linux/input.h>
+    #include <string.h>
+#endif
+
+bool OffscreenOutput::Open(QSize size)
+{
+    image = QImage(size, QImage::Format_RGB32);
+    frames = 0;
+    return !image.isNull();
+}
+
+#ifdef Q_OS_LINUX
+FramebufferOutput::FramebufferOutput(QString device)
+{
+    device_path = device;
+    fd = -1;
+    mapped = NULL;
+    map_size = 0;
+    line_length = 0;
+    page_height = 0;
+    flipping = false;
+    back_page = 0;
+}
+
+FramebufferOutput::~FramebufferOutput()
+{
+    Close();
+}
+
+bool FramebufferOutput::Open(QSize size)
+{
+    fd = open(device_path.toLocal8Bit().constData(), O_RDWR);
+    if (fd < 0) return false;
+
+    fb_var_screeninfo var;
+    fb_fix_screeninfo fix;
+    if (ioctl(fd, FBIOGET_VSCREENINFO, &var) < 0 || ioctl(fd, FBIOGET_FSCREENINFO, &fix) < 0)
+    {
+        Close();
+        return false;
+    }
+
+    // only the two pixel formats the car's panels actually use
+    QImage::Format format;
+    if (var.bits_per_pixel == 32)
+    {
+        format = QImage::Format_RGB32;
+    }
+    else if (var.bits_per_pixel == 16)
+    {
+        format = QImage::Format_RGB16;
+    }
+    else
+    {
+        Close();
+        return false;
+    }
+
+    // ask for a second page to flip to, fine if the driver says no
+    if (var.yres_virtual < var.yres * 2)
+    {
+        fb_var_screeninfo wanted = var;
+        wanted.yres_virtual = var.yres * 2;
+        wanted.yoffset = 0;
+        if (ioctl(fd, FBIOPUT_VSCREENINFO, &wanted) == 0)
+        {
+            ioctl(fd, FBIOGET_VSCREENINFO, &var);
+            ioctl(fd, FBIOGET_FSCREENINFO, &fix);
+        }
+    }
+
+    line_length = fix.line_length;
+    page_height = var.yres;
+    flipping = (var.yres_virtual >= var.yres * 2);
+    map_size = line_length * (flipping ? page_height * 2 : page_height);
+    mapped = (uchar *)mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+        mapped = NULL;
+        Close();
+        return false;
+    }
+
+    // the dashboard is drawn at its own size in the top left corner
+    int width = qMin((int)var.xres, size.width());
+    int height = qMin(page_height, size.height());
+    pages[0] = QImage(mapped, width, height, line_length, format);
+    if (flipping)
+    {
+        pages[1] = QImage(mapped + line_length * page_height, width, height, line_length, format);
+        back_page = 1;
+    }
+    else
+    {
+        staging = QImage(width, height, format);
+    }
+
+    return true;
+}
+
+void FramebufferOutput::Close()
+{
+    pages[0] = QImage();
+    pages[1] = QImage();
+    staging = QImage();
+    if (mapped != NULL) munmap(mapped, map_size);
+    mapped = NULL;
+    if (fd >= 0) close(fd);
+    fd = -1;
+}
+
+QImage *FramebufferOutput::BackBuffer()
+{
+    return flipping ? &pages[back_page] : &staging;
+}
+
+void FramebufferOutput::Present()
+{
+    if (fd < 0) return;
+
+    if (flipping)
+    {
+        // show the page just drawn, then draw the next frame on the other
+        fb_var_screeninfo var;
+        if (ioctl(fd, FBIOGET_VSCREENINFO, &var) == 0)
+        {
+            var.yoffset = back_page * page_height;
+            ioctl(fd, FBIOPAN_DISPLAY, &var);
+        }
+        back_page = 1 - back_page;
+    }
+    else
+    {
+        // one pass of whole-line copies into the visible buffer
+        int bytes = staging.bytesPerLine();
+        for (int y = 0; y < staging.height(); y++)
+        {
+            memcpy(mapped + y * line_length, staging.constScanLine(y), bytes);
+        }
+    }
+}
+#endif
+
+KioskRenderer::KioskRenderer(QWidget *root_widget, FrameOutput *frame_output, QObject *parent)
+    : QObject(parent)
+{
+    root = root_widget;
+    screen = root->size();
+    output = frame_output;
+    dirty = true;
+    rendering = false;
+    idle_ms = 0;
+
+    timer = new QTimer(this);
+    timer->setInterval(KIOSK_FRAME_MS);
+    connect(timer, SIGNAL(timeout()), this, SLOT(FrameTick()));
+}
+
+KioskRenderer::~KioskRenderer()
+{
+    Stop();
+    delete output;
+}
+
+bool KioskRenderer::Start()
+{
+    screen = root->size();
+    if (!output->Open(screen)) return false;
+
+    // the widgets are laid out and updated as usual, they just never
+    // get a window of their own
+    root->setAttribute(Qt::WA_DontShowOnScreen);
+
+    // any update anywhere in the dashboard means the next frame is needed
+    qApp->installEventFilter(this);
+    dirty = true;
+    timer->start();
+    return true;
+}
+
+void KioskRenderer::Stop()
+{
+    timer->stop();
+    qApp->removeEventFilter(this);
+    output->Close();
+}
+
+bool KioskRenderer::eventFilter(QObject *watched, QEvent *event)
+{
+    QEvent::Type type = event->type();
+
+    // rendering sends paint events of its own, those don't count
+    if (!rendering && (type == QEvent::UpdateRequest || type == QEvent::UpdateLater || type == QEvent::Paint))
+    {
+        QWidget *widget = qobject_cast<QWidget *>(watched);
+        if (widget != NULL && (widget->window() == root || windows.contains(widget->window()))) dirty = true;
+    }
+
+    // other windows get drawn into the frame too, polish comes before the
+    // window is created so they never get one of their own either
+    if (type == QEvent::Polish || type == QEvent::Show || type == QEvent::Hide)
+    {
+        QWidget *widget = qobject_cast<QWidget *>(watched);
+        if (widget != NULL && widget != root && widget->isWindow() &&
+            (widget->windowType() == Qt::Window || widget->windowType() == Qt::Dialog))
+        {
+            if (type == QEvent::Polish) widget->setAttribute(Qt::WA_DontShowOnScreen);
+            else if (type == QEvent::Show) Push(widget);
+            else Pop(widget);
+        }
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+QWidget *KioskRenderer::Top()
+{
+    return windows.isEmpty() ? root : windows.last();
+}
+
+QPoint KioskRenderer::Origin(QWidget *window)
+{
+    if (window == root || window->windowType() != Qt::Dialog) return QPoint();
+    return QPoint((screen.width() - window->width()) / 2, (screen.height() - window->height()) / 2);
+}
+
+void KioskRenderer::Push(QWidget *window)
+{
+    if (windows.contains(window)) return;
+
+    // pages take the whole screen whatever size they asked for
+    if (window->windowType() != Qt::Dialog) window->resize(screen);
+    windows.append(window);
+    connect(window, SIGNAL(destroyed(QObject *)), this, SLOT(WindowDestroyed(QObject *)), Qt::UniqueConnection);
+
+    dirty = true;
+    emit TopChanged(Top(), Origin(Top()));
+}
+
+void KioskRenderer::Pop(QWidget *window)
+{
+    if (windows.removeAll(window) == 0) return;
+
+    dirty = true;
+    emit TopChanged(Top(), Origin(Top()));
+}
+
+void KioskRenderer::WindowDestroyed(QObject *window)
+{
+    // only the pointer is compared, the widget is already gone
+    for (int i = 0; i < windows.size(); i++)
+    {
+        if ((QObject *)windows[i] == window)
+        {
+            windows.removeAt(i);
+            dirty = true;
+            emit TopChanged(Top(), Origin(Top()));
+            return;
+        }
+    }
+}
+
+void KioskRenderer::FrameTick()
+{
+    idle_ms += KIOSK_FRAME_MS;
+    if (!dirty && idle_ms < KIOSK_REFRESH_MS) return;
+    RenderFrame();
+}
+
+void KioskRenderer::RenderFrame()
+{
+    QImage *frame = output->BackBuffer();
+    if (frame == NULL || frame->isNull()) return;
+
+    // clear the flags first, anything that changes while rendering
+    // gets picked up on the next tick
+    dirty = false;
+    idle_ms = 0;
+
+    // gauges, readouts and the lap table all go into the one frame in a
+    // single walk of the widget tree, anything under the topmost page is
+    // covered so drawing starts there
+    int first = windows.size() - 1;
+    while (first >= 0 && windows[first]->windowType() == Qt::Dialog) first--;
+
+    rendering = true;
+    QPainter painter(frame);
+    if (first < 0)
+    {
+        root->render(&painter, QPoint(), QRegion(), QWidget::DrawWindowBackground | QWidget::DrawChildren);
+        first = 0;
+    }
+    for (int i = first; i < windows.size(); i++)
+    {
+        windows[i]->render(&painter, Origin(windows[i]), QRegion(), QWidget::DrawWindowBackground | QWidget::DrawChildren);
+    }
+    painter.end();
+    rendering = false;
+
+    output->Present();
+}
+
+#ifdef Q_OS_LINUX
+KioskTouch::KioskTouch(QWidget *root_widget, QString device, QObject *parent)
+    : QObject(parent)
+{
+    screen = root_widget;
+    root = root_widget;
+    pressed_widget = NULL;
+    notifier = NULL;
+    raw_x = raw_y = 0;
+    touching = was_touching = false;
+
+    // default to a 1:1 mapping if the device doesn't report its ranges
+    x_min = y_min = 0;
+    x_max = screen->width();
+    y_max = screen->height();
+
+    fd = open(device.toLocal8Bit().constData(), O_RDONLY | O_NONBLOCK);
+    if (fd < 0) return;
+
+    input_absinfo info;
+    if (ioctl(fd, EVIOCGABS(ABS_X), &info) == 0 && info.maximum > info.minimum)
+    {
+        x_min = info.minimum;
+        x_max = info.maximum;
+    }
+    if (ioctl(fd, EVIOCGABS(ABS_Y), &info) == 0 && info.maximum > info.minimum)
+    {
+        y_min = info.minimum;
+        y_max = info.maximum;
+    }
+
+    notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(notifier, SIGNAL(activated(int)), this, SLOT(ReadEvents()));
+}
+
+KioskTouch::~KioskTouch()
+{
+    if (fd >= 0) close(fd);
+}
+
+void KioskTouch::ReadEvents()
+{
+    input_event events[64];
+    int bytes;
+    while ((bytes = read(fd, events, sizeof(events))) > 0)
+    {
+        int count = bytes / sizeof(input_event);
+        for (int i = 0; i < count; i++)
+        {
+            const input_event &ev = events[i];
+            if (ev.type == EV_ABS && ev.code == ABS_X)
+            {
+                raw_x = ev.value;
+            }
+            else if (ev.type == EV_ABS && ev.code == ABS_Y)
+            {
+                raw_y = ev.value;
+            }
+            else if (ev.type == EV_KEY && ev.code == BTN_TOUCH)
+            {
+                touching = (ev.value != 0);
+            }
+            else if (ev.type == EV_SYN && ev.code == SYN_REPORT)
+            {
+                // a complete report, scale it to the dashboard and pass it on
+                QPoint pos((raw_x - x_min) * screen->width() / (x_max - x_min),
+                           (raw_y - y_min) * screen->height() / (y_max - y_min));
+                if (touching && !was_touching)
+                {
+                    SendMouse(QEvent::MouseButtonPress, pos);
+                }
+                else if (!touching && was_touching)
+                {
+                    SendMouse(QEvent::MouseButtonRelease, pos);
+                }
+                else if (touching)
+                {
+                    SendMouse(QEvent::MouseMove, pos);
+                }
+                was_touching = touching;
+            }
+        }
+    }
+}
+
+void KioskTouch::SetRoot(QWidget *root_widget, QPoint root_origin)
+{
+    // a press that was under way stays with the window it started in
+    root = root_widget;
+    origin = root_origin;
+}
+
+void KioskTouch::SendMouse(QEvent::Type type, QPoint pos)
+{
+    pos -= origin;
+
+    // like a real mouse, everything after the press goes to the widget
+    // that was pressed so buttons see a matching release
+    QWidget *target;
+    if (type == QEvent::MouseButtonPress || pressed_widget == NULL)
+    {
+        target = root->childAt(pos);
+        if (target == NULL) target = root;
+        pressed_widget = target;
+    }
+    else
+    {
+        target = pressed_widget;
+    }
+
+    Qt::MouseButtons buttons = (type == QEvent::MouseButtonRelease) ? Qt::NoButton : Qt::LeftButton;
+    Qt::MouseButton button = (type == QEvent::MouseMove) ? Qt::NoButton : Qt::LeftButton;
+
+    // the pressed widget may belong to a window that has since been
+    // covered, so map through global coordinates rather than from root
+    QPoint global = root->mapToGlobal(pos);
+    QMouseEvent event(type, target->mapFromGlobal(global), global, button, buttons, Qt::NoModifier);
+    QApplication::sendEvent(target, &event);
+
+    if (type == QEvent::MouseButtonRelease) pressed_widget = NULL;
+}
+#endif
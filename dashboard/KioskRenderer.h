@@ -0,0 +1,186 @@
+#ifndef KIOSKRENDERER_H
+#define KIOSKRENDERER_H
+
+#include <QObject>
+#include <QWidget>
+#include <QApplication>
+#include <QImage>
+#include <QPainter>
+#include <QTimer>
+#include <QEvent>
+#include <QMouseEvent>
+#include <QString>
+#include <QSize>
+#include <QPoint>
+#include <QPointer>
+#include <QList>
+
+#ifdef Q_OS_LINUX
+    #include <QSocketNotifier>
+#endif
+
+// how often the kiosk checks for changes to present (in ms)
+#define KIOSK_FRAME_MS 33
+
+// a frame is presented at least this often even if nothing changed,
+// so a stray missed update can't leave the screen stale for long (in ms)
+#define KIOSK_REFRESH_MS 1000
+
+// default devices for the linux framebuffer kiosk
+#define KIOSK_FB_DEVICE "/dev/fb0"
+#define KIOSK_TOUCH_DEVICE "/dev/input/event0"
+
+// where finished frames go, swap in an OffscreenOutput to render the
+// dashboard without any display at all (e.g. for tests)
+class FrameOutput
+{
+public:
+    virtual ~FrameOutput() {}
+    virtual bool Open(QSize size) = 0;
+    virtual void Close() = 0;
+
+    // the image the next frame gets drawn into
+    virtual QImage *BackBuffer() = 0;
+
+    // show what was drawn into the back buffer
+    virtual void Present() = 0;
+};
+
+class OffscreenOutput : public FrameOutput
+{
+public:
+    OffscreenOutput() { frames = 0; }
+    bool Open(QSize size);
+    void Close() { image = QImage(); }
+    QImage *BackBuffer() { return &image; }
+    void Present() { frames++; }
+
+    const QImage &Frame() { return image; }
+    int FrameCount() { return frames; }
+
+private:
+    QImage image;
+    int frames;
+};
+
+#ifdef Q_OS_LINUX
+// linux fbdev output, the mapped framebuffer is drawn into directly
+// if the device has room for two pages they are flipped with a pan,
+// otherwise frames are drawn off screen and copied in whole
+// (DRM-only systems expose the same interface through fbdev emulation)
+class FramebufferOutput : public FrameOutput
+{
+public:
+    FramebufferOutput(QString device = KIOSK_FB_DEVICE);
+    ~FramebufferOutput();
+    bool Open(QSize size);
+    void Close();
+    QImage *BackBuffer();
+    void Present();
+
+private:
+    QString device_path;
+    int fd;
+    uchar *mapped;
+    int map_size;
+    int line_length;
+    int page_height; // visible lines
+    bool flipping;
+    int back_page;
+    QImage pages[2];
+    QImage staging; // used when the device can't flip
+};
+#endif
+
+// renders the whole dashboard widget tree into one software frame in a
+// single pass and presents it through a FrameOutput, no desktop or
+// window manager involved; the widgets never appear on screen themselves
+// note what this doesn't do: QApplication still has to start, so an X11
+// build of Qt still needs a display connection (a bare X server is
+// enough), output is through fbdev (on DRM-only systems that means the
+// kernel's fbdev emulation, dumb buffers aren't driven directly), and
+// it is only built on linux, so today it runs in the test harness build
+// and not in the car build, which is win32
+// any other window shown while it runs (the options page, a message box)
+// is stacked over the dashboard until it hides, pages fill the frame and
+// dialogs are centred over whatever is under them
+class KioskRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // takes ownership of output
+    KioskRenderer(QWidget *root_widget, FrameOutput *frame_output, QObject *parent = 0);
+    ~KioskRenderer();
+
+    bool Start();
+    void Stop();
+
+    // the window on top, which is where touches should go, and where
+    // it's drawn in the frame
+    QWidget *Top();
+    QPoint Origin(QWidget *window);
+
+public slots:
+    void RenderFrame();
+
+signals:
+    void TopChanged(QWidget *top, QPoint origin);
+
+private slots:
+    void FrameTick();
+    void WindowDestroyed(QObject *window);
+
+protected:
+    virtual bool eventFilter(QObject *watched, QEvent *event);
+
+private:
+    QWidget *root;
+    QList<QWidget *> windows; // shown over the root, newest last
+    QSize screen;
+    FrameOutput *output;
+    QTimer *timer;
+    bool dirty;
+    bool rendering;
+    int idle_ms;
+
+    void Push(QWidget *window);
+    void Pop(QWidget *window);
+};
+
+#ifdef Q_OS_LINUX
+// feeds a linux evdev touch screen into the kiosk's widgets as mouse
+// presses and releases, since there's no window system to do it
+class KioskTouch : public QObject
+{
+    Q_OBJECT
+
+public:
+    KioskTouch(QWidget *root_widget, QString device = KIOSK_TOUCH_DEVICE, QObject *parent = 0);
+    ~KioskTouch();
+
+    bool IsOpen() { return fd >= 0; }
+
+public slots:
+    // send touches to another window, drawn at origin in the frame
+    void SetRoot(QWidget *root_widget, QPoint root_origin);
+
+private slots:
+    void ReadEvents();
+
+private:
+    QWidget *screen; // what the touch screen is scaled to
+    QWidget *root;
+    QPoint origin;
+    QPointer<QWidget> pressed_widget; // cleared if it goes away mid-touch (e.g. a message box)
+    QSocketNotifier *notifier;
+    int fd;
+    int x_min, x_max, y_min, y_max;
+    int raw_x, raw_y;
+    bool touching, was_touching;
+
+    void SendMouse(QEvent::Type type, QPoint pos);
+};
+#endif
+
+#endif // KIOSKRENDERER_H
@@ -0,0 +1,129 @@
+#include "LapDetector.h"
+
+#include <cmath>
+#include <cstring>
+
+LapDetector::LapDetector(QObject *parent)
+    : QObject(parent)
+{
+    has_gate = false;
+    gate_lat = 0.0;
+    gate_lon = 0.0;
+    gate_heading = 0.0;
+    has_last = false;
+    last_ms = 0;
+    last_crossing_ms = 0;
+    memset(&last_state, 0, sizeof(last_state));
+}
+
+void LapDetector::SetGate(double lat, double lon, double heading)
+{
+    const double rad_per_deg = 3.14159265358979323846 / 180.0;
+
+    gate_lat = lat;
+    gate_lon = lon;
+    gate_heading = heading;
+    projection.SetOrigin(lat, lon);
+
+    // heading is clockwise from north, the gate runs from the driver's
+    // left to their right so a forward crossing has a known winding
+    double fx = sin(heading * rad_per_deg);
+    double fy = cos(heading * rad_per_deg);
+    gate_a = QPointF(-fy * LAPGATE_HALF_WIDTH_M, fx * LAPGATE_HALF_WIDTH_M);
+    gate_b = QPointF(fy * LAPGATE_HALF_WIDTH_M, -fx * LAPGATE_HALF_WIDTH_M);
+    has_gate = true;
+
+    // the last fix was projected around the old gate
+    has_last = false;
+}
+
+void LapDetector::SetGateHere()
+{
+    if (!LocalProjection::HasFix(last_state.pos)) return;
+
+    SetGate(LocalProjection::Latitude(last_state.pos),
+            LocalProjection::Longitude(last_state.pos),
+            last_state.heading);
+    Save(LAPGATE_FILENAME);
+}
+
+void LapDetector::Reset()
+{
+    has_last = false;
+    last_crossing_ms = 0;
+}
+
+void LapDetector::GpsUpdate(gpsstate_t state)
+{
+    last_state = state;
+    if (!has_gate || !LocalProjection::HasFix(state.pos)) return;
+
+    QPointF p = projection.Project(state.pos);
+    int ms = state.timestamp;
+    if (!has_last || ms <= last_ms)
+    {
+        last = p;
+        last_ms = ms;
+        has_last = true;
+        return;
+    }
+
+    // where the step from the last fix meets the line, as fractions
+    // along the step (s) and along the gate (g)
+    QPointF step = p - last;
+    QPointF gate = gate_b - gate_a;
+    QPointF to_gate = gate_a - last;
+    double denom = step.x() * gate.y() - step.y() * gate.x();
+
+    // forward crossings go left to right across the gate, which is a
+    // negative cross product of the step with the gate
+    if (denom < 0.0)
+    {
+        double s = (to_gate.x() * gate.y() - to_gate.y() * gate.x()) / denom;
+        double g = (to_gate.x() * step.y() - to_gate.y() * step.x()) / denom;
+        if (s >= 0.0 && s <= 1.0 && g >= 0.0 && g <= 1.0)
+        {
+            int crossing_ms = last_ms + (int)(s * (ms - last_ms) + 0.5);
+            if (crossing_ms - last_crossing_ms >= LAPGATE_MIN_LAP_MS)
+            {
+                last_crossing_ms = crossing_ms;
+                emit LapCrossed(crossing_ms);
+            }
+        }
+    }
+
+    last = p;
+    last_ms = ms;
+}
+
+bool LapDetector::Save(QString filepath) const
+{
+    if (!has_gate) return false;
+
+    QFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_5);
+    stream << (quint32)LAPGATE_MAGIC << gate_lat << gate_lon << gate_heading;
+
+    file.close();
+    return stream.status() == QDataStream::Ok;
+}
+
+bool LapDetector::Load(QString filepath)
+{
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_5);
+
+    quint32 magic = 0;
+    double lat, lon, heading;
+    stream >> magic >> lat >> lon >> heading;
+    if (magic != LAPGATE_MAGIC || stream.status() != QDataStream::Ok) return false;
+
+    SetGate(lat, lon, heading);
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef LAPDETECTOR_H
+#define LAPDETECTOR_H
+
+#include <QObject>
+#include <QFile>
+#include <QString>
+#include <QPointF>
+#include <QDataStream>
+
+#include "ucvtypes.h"
+#include "LocalProjection.h"
+
+// identifies (and versions) the start/finish gate file format
+#define LAPGATE_MAGIC 0x55434731 // "UCG1"
+
+// where the start/finish gate is kept, next to the logs
+#define LAPGATE_FILENAME "startfinish.gate"
+
+// half the width of the gate either side of where it was set (in m)
+#define LAPGATE_HALF_WIDTH_M 15.0
+
+// crossings sooner than this after the run starts or after the last lap
+// (in ms) are gps jitter around the line, not laps
+#define LAPGATE_MIN_LAP_MS 30000
+
+// counts laps by watching consecutive gps fixes for a segment that crosses
+// the start/finish line, the crossing time is interpolated between the two
+// fixes' timestamps so a lap is timed to the ms rather than to the fix rate
+// it sits straight on the parser's output so a lap is timed from the sample
+// timestamps, not from whenever the gui gets round to it
+class LapDetector : public QObject
+{
+    Q_OBJECT
+
+public:
+    LapDetector(QObject *parent = 0);
+
+    bool HasGate() const { return has_gate; }
+
+    // gate across the track at a position, facing the direction of travel
+    void SetGate(double lat, double lon, double heading);
+
+    bool Save(QString filepath) const;
+    bool Load(QString filepath);
+
+public slots:
+    void GpsUpdate(gpsstate_t state);
+
+    // put the gate where the car is now, across the way it's heading
+    void SetGateHere();
+
+    // forget the last fix and crossing, at the start of a run
+    void Reset();
+
+signals:
+    // the car crossed the line going forwards at this time (in ms since the timer started)
+    void LapCrossed(int ms);
+
+private:
+    LocalProjection projection; // centered on the gate
+    bool has_gate;
+    double gate_lat, gate_lon, gate_heading;
+    QPointF gate_a, gate_b; // ends of the line (in m)
+
+    bool has_last;
+    QPointF last; // previous fix (in m)
+    int last_ms;
+    gpsstate_t last_state;
+    int last_crossing_ms;
+};
+
+#endif // LAPDETECTOR_H
@@ -0,0 +1,194 @@
+#include "LatencyMonitor.h"
+
+#include <QCoreApplication>
+#include <QPointer>
+
+static const char *channel_names[LAT_CHANNELS] = { "RPM", "Speed", "Loop" };
+static const char *kind_names[LAT_KINDS] = { "lag", "pixel", "paint" };
+
+static QElapsedTimer &LatencyTimer()
+{
+    static QElapsedTimer clock;
+    if (!clock.isValid()) clock.start();
+    return clock;
+}
+
+qint64 LatencyClock::Now()
+{
+    return LatencyTimer().nsecsElapsed() / 1000;
+}
+
+qint64 LatencyClock::SystemOffset()
+{
+    // msecsSinceReference is when the timer was started
+    return LatencyTimer().msecsSinceReference() * 1000;
+}
+
+void LatencyHistogram::Clear()
+{
+    for (int i = 0; i < LATENCY_BUCKETS; i++) counts[i] = 0;
+    count = 0;
+}
+
+void LatencyHistogram::Add(qint64 us)
+{
+    // bucket is the position of the highest set bit
+    int bucket = 0;
+    while (us > 1 && bucket < LATENCY_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+    counts[bucket]++;
+    count++;
+}
+
+double LatencyHistogram::Percentile(double fraction) const
+{
+    if (count == 0) return 0.0;
+
+    double target = fraction * count;
+    double seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        if (counts[i] == 0) continue;
+        if (seen + counts[i] >= target)
+        {
+            // spread the bucket's samples evenly from 2^i to 2^(i+1)
+            double low = (i == 0) ? 0.0 : (double)(1 << i);
+            double high = (double)(1 << (i + 1));
+            return low + (high - low) * (target - seen) / counts[i];
+        }
+        seen += counts[i];
+    }
+    return (double)(1 << LATENCY_BUCKETS);
+}
+
+LatencyMonitor *LatencyMonitor::instance()
+{
+    // owned by the application like RunClock
+    static QPointer<LatencyMonitor> monitor;
+    if (monitor.isNull()) monitor = new LatencyMonitor();
+    return monitor;
+}
+
+LatencyMonitor::LatencyMonitor()
+    : QObject(qApp)
+{
+    for (int c = 0; c < LAT_CHANNELS; c++) pending[c] = 0;
+
+    // a timer that should fire every LATENCY_PROBE_MS, however late it
+    // actually fires is how long the event loop was busy with something else
+    probe_timer.setInterval(LATENCY_PROBE_MS);
+    connect(&probe_timer, SIGNAL(timeout()), this, SLOT(Probe()));
+    probe_due = LatencyClock::Now() + LATENCY_PROBE_MS * 1000;
+    probe_timer.start();
+}
+
+void LatencyMonitor::Delivered(int channel, qint64 acquired)
+{
+    if (acquired <= 0) return; // replayed from a log, no acquisition time
+
+    hist[channel][LAT_LAG].Add(LatencyClock::Now() - acquired);
+
+    // the next paint shows the newest sample, older unpainted ones
+    // were never seen at all
+    pending[channel] = acquired;
+}
+
+void LatencyMonitor::Painted(int channel, int paint_us)
+{
+    hist[channel][LAT_PAINT].Add(paint_us);
+
+    if (pending[channel] != 0)
+    {
+        hist[channel][LAT_PIXEL].Add(LatencyClock::Now() - pending[channel]);
+        pending[channel] = 0;
+    }
+}
+
+void LatencyMonitor::Probe()
+{
+    qint64 now = LatencyClock::Now();
+    hist[LAT_LOOP][LAT_LAG].Add(qMax(now - probe_due, (qint64)0));
+    probe_due = now + LATENCY_PROBE_MS * 1000;
+}
+
+void LatencyMonitor::Clear()
+{
+    for (int c = 0; c < LAT_CHANNELS; c++)
+    {
+        for (int k = 0; k < LAT_KINDS; k++) hist[c][k].Clear();
+        pending[c] = 0;
+    }
+}
+
+const char *LatencyMonitor::ChannelName(int channel)
+{
+    if (channel < 0 || channel >= LAT_CHANNELS) return "";
+    return channel_names[channel];
+}
+
+const char *LatencyMonitor::KindName(int kind)
+{
+    if (kind < 0 || kind >= LAT_KINDS) return "";
+    return kind_names[kind];
+}
+
+LatencyOverlay::LatencyOverlay(QWidget *parent)
+    : QWidget(parent)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setFont(QFont("Fixed", 10, QFont::Bold));
+    QFontMetrics metrics(font());
+    resize(metrics.width("Speed  pixel  9999.9 / 9999.9 ms") + 12,
+           metrics.height() * (LAT_CHANNELS * LAT_KINDS + 1) + 8);
+
+    timer = new QTimer(this);
+    timer->setInterval(LATENCY_OVERLAY_MS);
+    connect(timer, SIGNAL(timeout()), this, SLOT(update()));
+
+    QWidget::setVisible(false);
+}
+
+void LatencyOverlay::setVisible(bool visible)
+{
+    // only refresh while it's up
+    if (visible)
+    {
+        raise();
+        timer->start();
+    }
+    else
+    {
+        timer->stop();
+    }
+    QWidget::setVisible(visible);
+}
+
+void LatencyOverlay::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(0, 0, 0, 200));
+    painter.setPen(Qt::white);
+
+    LatencyMonitor *monitor = LatencyMonitor::instance();
+    int line = fontMetrics().height();
+    int y = 4 + fontMetrics().ascent();
+    painter.drawText(6, y, "          p50 / p99");
+    for (int c = 0; c < LAT_CHANNELS; c++)
+    {
+        for (int k = 0; k < LAT_KINDS; k++)
+        {
+            const LatencyHistogram &hist = monitor->Histogram(c, k);
+            if (hist.Count() == 0) continue;
+
+            y += line;
+            painter.drawText(6, y, QString("%1 %2 %3 / %4 ms")
+                             .arg(LatencyMonitor::ChannelName(c), -6)
+                             .arg(LatencyMonitor::KindName(k), -5)
+                             .arg(hist.Percentile(0.50) / 1000.0, 6, 'f', 1)
+                             .arg(hist.Percentile(0.99) / 1000.0, 6, 'f', 1));
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef LATENCYMONITOR_H
+#define LATENCYMONITOR_H
+
+#include <QObject>
+#include <QWidget>
+#include <QTimer>
+#include <QPainter>
+#include <QElapsedTimer>
+#include <QString>
+
+#include "ucvtypes.h"
+
+// how often the event loop lag probe fires (in ms)
+#define LATENCY_PROBE_MS 50
+
+// how often the overlay refreshes its numbers (in ms)
+#define LATENCY_OVERLAY_MS 500
+
+// what a histogram is measuring
+typedef enum {
+    LAT_RPM = 0, // tachometer gauge and readout
+    LAT_SPEED, // speedometer gauge and readout
+    LAT_LOOP, // the event loop itself (lag only)
+    LAT_CHANNELS
+} latency_channel_t;
+
+typedef enum {
+    LAT_LAG = 0, // acquisition (or due time) to the slot handling it
+    LAT_PIXEL, // acquisition to the first paint showing the sample
+    LAT_PAINT, // time spent painting the channel's widgets
+    LAT_KINDS
+} latency_kind_t;
+
+// monotonic time shared by the acquisition stamps and the paint side
+class LatencyClock
+{
+public:
+    static qint64 Now(); // in us since first use
+
+    // where Now() started on the system wide monotonic clock (in us since
+    // its reference), so another process can line up times with this one
+    static qint64 SystemOffset();
+};
+
+// log2 bucketed histogram of times in us, adding is allocation free
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() { Clear(); }
+    void Clear();
+    void Add(qint64 us);
+
+    int Count() const { return count; }
+    unsigned int Bucket(int i) const { return counts[i]; }
+
+    // estimated time (in us) below which the given fraction of samples fall,
+    // interpolated within the bucket
+    double Percentile(double fraction) const;
+
+private:
+    unsigned int counts[LATENCY_BUCKETS];
+    int count;
+};
+
+// collects sensor-to-pixel latency, paint time and event loop lag for
+// the dashboard, one instance shared by the dashboard and the logger
+class LatencyMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    static LatencyMonitor *instance();
+
+    // a sample for the channel reached its slot
+    void Delivered(int channel, qint64 acquired);
+
+    // one of the channel's widgets finished painting
+    void Painted(int channel, int paint_us);
+
+    void Clear();
+    const LatencyHistogram &Histogram(int channel, int kind) { return hist[channel][kind]; }
+
+    static const char *ChannelName(int channel);
+    static const char *KindName(int kind);
+
+private slots:
+    void Probe();
+
+private:
+    LatencyMonitor();
+
+    LatencyHistogram hist[LAT_CHANNELS][LAT_KINDS];
+    qint64 pending[LAT_CHANNELS]; // newest sample not painted yet, 0 if none
+    QTimer probe_timer;
+    qint64 probe_due;
+};
+
+// p50/p99 of every histogram drawn over the dashboard
+class LatencyOverlay : public QWidget
+{
+    Q_OBJECT
+
+public:
+    LatencyOverlay(QWidget *parent = 0);
+
+public slots:
+    void setVisible(bool visible);
+
+protected:
+    virtual void paintEvent(QPaintEvent *event);
+
+private:
+    QTimer *timer;
+};
+
+#endif // LATENCYMONITOR_H
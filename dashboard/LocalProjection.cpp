@@ -0,0 +1,54 @@
+#include "LocalProjection.h"
+
+#include <cmath>
+
+LocalProjection::LocalProjection()
+{
+    valid = false;
+    lat0 = 0.0;
+    lon0 = 0.0;
+    m_per_deg_lat = 0.0;
+    m_per_deg_lon = 0.0;
+}
+
+void LocalProjection::SetOrigin(double lat, double lon)
+{
+    const double rad_per_deg = 3.14159265358979323846 / 180.0;
+
+    lat0 = lat;
+    lon0 = lon;
+
+    // lines of longitude get closer together away from the equator,
+    // the scale at the origin is good enough for the whole track
+    m_per_deg_lat = EARTH_RADIUS_M * rad_per_deg;
+    m_per_deg_lon = m_per_deg_lat * cos(lat0 * rad_per_deg);
+    valid = true;
+}
+
+QPointF LocalProjection::Project(double lat, double lon) const
+{
+    return QPointF((lon - lon0) * m_per_deg_lon, (lat - lat0) * m_per_deg_lat);
+}
+
+QPointF LocalProjection::Project(const gpspos_t &pos) const
+{
+    return Project(Latitude(pos), Longitude(pos));
+}
+
+double LocalProjection::Latitude(const gpspos_t &pos)
+{
+    double deg = pos.lat_deg + pos.lat_mins / 60.0;
+    return (pos.lat_dir == GPS_SOUTH) ? -deg : deg;
+}
+
+double LocalProjection::Longitude(const gpspos_t &pos)
+{
+    double deg = pos.long_deg + pos.long_mins / 60.0;
+    return (pos.long_dir == GPS_WEST) ? -deg : deg;
+}
+
+bool LocalProjection::HasFix(const gpspos_t &pos)
+{
+    return pos.lat_deg != 0 || pos.lat_mins != 0.0 ||
+           pos.long_deg != 0 || pos.long_mins != 0.0;
+}
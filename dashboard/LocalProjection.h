@@ -0,0 +1,41 @@
+#ifndef LOCALPROJECTION_H
+#define LOCALPROJECTION_H
+
+#include <QPointF>
+
+#include "ucvtypes.h"
+
+// mean radius of the earth (in m)
+#define EARTH_RADIUS_M 6371000.0
+
+// flattens gps positions onto a plane of metres east (x) and north (y)
+// of an origin picked once per track, over a track a few km across the
+// error of treating the earth as flat there is far below the gps noise
+// the only trig happens when the origin is set, every projection after
+// that is a subtract and a multiply per axis
+class LocalProjection
+{
+public:
+    LocalProjection();
+
+    void SetOrigin(double lat, double lon);
+    void Reset() { valid = false; }
+    bool IsSet() const { return valid; }
+
+    QPointF Project(double lat, double lon) const;
+    QPointF Project(const gpspos_t &pos) const;
+
+    // signed decimal degrees (north and east positive) of a gps position
+    static double Latitude(const gpspos_t &pos);
+    static double Longitude(const gpspos_t &pos);
+
+    // the receiver reports all zeros until it has a fix
+    static bool HasFix(const gpspos_t &pos);
+
+private:
+    bool valid;
+    double lat0, lon0; // origin (in degrees)
+    double m_per_deg_lat, m_per_deg_lon;
+};
+
+#endif // LOCALPROJECTION_H
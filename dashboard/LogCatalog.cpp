@@ -0,0 +1,307 @@
+#include "LogCatalog.h"
+
+LogSummary::LogSummary()
+{
+    Reset(QString());
+}
+
+void LogSummary::Reset(QString name)
+{
+    filename = name;
+
+    // logs are named after the time they were started
+    start = QDateTime::fromString(QFileInfo(name).completeBaseName(), "yyyy-MM-dd_hh-mm-ss");
+    modified = QDateTime();
+    size = 0;
+    first_timestamp = 0;
+    last_timestamp = -1;
+    laps = 0;
+    max_rpm = 0;
+    for (int i = 0; i < CATALOG_RECORD_TYPES; i++) record_counts[i] = 0;
+}
+
+void LogSummary::Add(const logrecord_t &record)
+{
+    AddRecord(record.type, record.ecu.timestamp);
+
+    switch (record.type)
+    {
+    case ECU_RECORD:
+        AddRpm(record.ecu.rpm);
+        break;
+    case LAP_RECORD:
+        AddLap(record.lap.lap);
+        break;
+    }
+}
+
+void LogSummary::AddRecord(int type, int timestamp)
+{
+    if (TotalRecords() == 0 || timestamp < first_timestamp) first_timestamp = timestamp;
+    if (timestamp > last_timestamp) last_timestamp = timestamp;
+
+    if (type >= 0 && type < CATALOG_RECORD_TYPES) record_counts[type]++;
+}
+
+void LogSummary::Stat(QDir dir)
+{
+    QFileInfo info(dir.absoluteFilePath(filename));
+    size = info.size();
+    modified = info.lastModified();
+    if (!start.isValid()) start = info.created();
+}
+
+int LogSummary::TotalRecords()
+{
+    int total = 0;
+    for (int i = 0; i < CATALOG_RECORD_TYPES; i++) total += record_counts[i];
+    return total;
+}
+
+QDataStream &operator<<(QDataStream &out, const LogSummary &summary)
+{
+    out << summary.filename << summary.start << summary.modified;
+    out << summary.size;
+    out << (qint32)summary.first_timestamp << (qint32)summary.last_timestamp;
+    out << (qint32)summary.laps << (qint32)summary.max_rpm;
+    for (int i = 0; i < CATALOG_RECORD_TYPES; i++) out << (qint32)summary.record_counts[i];
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, LogSummary &summary)
+{
+    qint32 first, last, laps, max_rpm, count;
+
+    in >> summary.filename >> summary.start >> summary.modified;
+    in >> summary.size;
+    in >> first >> last >> laps >> max_rpm;
+    summary.first_timestamp = first;
+    summary.last_timestamp = last;
+    summary.laps = laps;
+    summary.max_rpm = max_rpm;
+    for (int i = 0; i < CATALOG_RECORD_TYPES; i++)
+    {
+        in >> count;
+        summary.record_counts[i] = count;
+    }
+    return in;
+}
+
+LogCatalog::LogCatalog()
+{
+    // nothing yet
+}
+
+bool LogCatalog::Load()
+{
+    entries.clear();
+
+    QFile file(directory.absoluteFilePath(CATALOG_FILENAME));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_5);
+
+    quint32 magic = 0;
+    qint32 count = 0;
+    stream >> magic >> count;
+    if (magic != CATALOG_MAGIC) return false;
+
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        LogSummary summary;
+        stream >> summary;
+        if (stream.status() == QDataStream::Ok) entries.append(summary);
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool LogCatalog::Save()
+{
+    // write a new catalog beside the old one and swap it in, so a crash
+    // halfway through never leaves a half written catalog behind
+    QString filepath = directory.absoluteFilePath(CATALOG_FILENAME);
+    QString temppath = filepath + ".new";
+
+    QFile file(temppath);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_5);
+    stream << (quint32)CATALOG_MAGIC << (qint32)entries.size();
+    for (int i = 0; i < entries.size(); i++)
+    {
+        stream << entries[i];
+    }
+    file.close();
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        QFile::remove(temppath);
+        return false;
+    }
+
+    QFile::remove(filepath);
+    return QFile::rename(temppath, filepath);
+}
+
+void LogCatalog::Update(const LogSummary &summary)
+{
+    int i = IndexOf(summary.filename);
+    if (i >= 0)
+    {
+        entries[i] = summary;
+    }
+    else
+    {
+        entries.append(summary);
+    }
+}
+
+void LogCatalog::Prune()
+{
+    for (int i = entries.size() - 1; i >= 0; i--)
+    {
+        if (!directory.exists(entries[i].filename)) entries.removeAt(i);
+    }
+}
+
+QStringList LogCatalog::Unknown()
+{
+    QStringList unknown;
+    QFileInfoList files = directory.entryInfoList(QStringList("*.ucv"), QDir::Files);
+
+    for (int i = 0; i < files.size(); i++)
+    {
+        int e = IndexOf(files[i].fileName());
+        if (e < 0 || entries[e].size != files[i].size() || entries[e].modified != files[i].lastModified())
+        {
+            unknown.append(files[i].fileName());
+        }
+    }
+
+    return unknown;
+}
+
+bool LogCatalog::Find(QString filename, LogSummary *summary)
+{
+    int i = IndexOf(filename);
+    if (i < 0) return false;
+
+    *summary = entries[i];
+    return true;
+}
+
+bool LogCatalog::Summarize(QDir dir, QString filename, LogSummary *summary)
+{
+    LogReader reader;
+    if (!reader.Open(dir.absoluteFilePath(filename))) return false;
+
+    summary->Reset(filename);
+
+    logrecord_t record;
+    while (reader.Next(&record))
+    {
+        summary->Add(record);
+    }
+
+    reader.Close();
+    summary->Stat(dir);
+    return true;
+}
+
+int LogCatalog::IndexOf(QString filename)
+{
+    for (int i = 0; i < entries.size(); i++)
+    {
+        if (entries[i].filename == filename) return i;
+    }
+    return -1;
+}
+
+QMutex *LogCatalog::FileLock()
+{
+    static QMutex lock;
+    return &lock;
+}
+
+CatalogScanner::CatalogScanner(QObject *parent)
+    : QThread(parent)
+{
+    // nothing yet
+}
+
+void CatalogScanner::SetFiles(QDir dir, QStringList filenames)
+{
+    if (isRunning()) return;
+
+    directory = dir;
+    files = filenames;
+}
+
+void CatalogScanner::run()
+{
+    results.clear();
+
+    for (int i = 0; i < files.size(); i++)
+    {
+        LogSummary summary;
+        if (LogCatalog::Summarize(directory, files[i], &summary))
+        {
+            results.append(summary);
+        }
+    }
+}
+
+CatalogWriter::CatalogWriter(QObject *parent)
+    : QThread(parent)
+{
+    busy = false;
+}
+
+void CatalogWriter::Add(QDir dir, const LogSummary &summary)
+{
+    mutex.lock();
+    directory = dir;
+    pending.append(summary);
+    bool start_needed = !busy;
+    busy = true;
+    mutex.unlock();
+
+    // a thread that found nothing left to do may still be on its way out
+    if (start_needed)
+    {
+        wait();
+        start(QThread::LowPriority);
+    }
+}
+
+void CatalogWriter::run()
+{
+    while (true)
+    {
+        mutex.lock();
+        if (pending.isEmpty())
+        {
+            busy = false;
+            mutex.unlock();
+            return;
+        }
+        QList<LogSummary> summaries = pending;
+        QDir dir = directory;
+        pending.clear();
+        mutex.unlock();
+
+        // everything queued so far goes in with one rewrite
+        QMutexLocker locker(LogCatalog::FileLock());
+        LogCatalog catalog;
+        catalog.SetDirectory(dir);
+        catalog.Load();
+        for (int i = 0; i < summaries.size(); i++)
+        {
+            catalog.Update(summaries[i]);
+        }
+        catalog.Save();
+    }
+}
@@ -0,0 +1,145 @@
+#ifndef LOGCATALOG_H
+#define LOGCATALOG_H
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QThread>
+#include <QMutex>
+
+#include "LogReader.h"
+#include "ucvtypes.h"
+
+// name of the catalog file kept beside the logs
+#define CATALOG_FILENAME "catalog.ucx"
+
+// identifies (and versions) the catalog file format
+#define CATALOG_MAGIC 0x55435831 // "UCX1"
+
+// the number of record types counted per log (indexed by record type)
+#define CATALOG_RECORD_TYPES (LAP_RECORD + 1)
+
+// everything the catalog knows about a single log file
+class LogSummary
+{
+public:
+    LogSummary();
+
+    // start a fresh summary for the given log file
+    void Reset(QString name);
+
+    // accumulate a record into the summary
+    void Add(const logrecord_t &record);
+    void AddRecord(int type, int timestamp);
+    void AddRpm(int rpm) { if (rpm > max_rpm) max_rpm = rpm; }
+    void AddLap(int lap) { if (lap > laps) laps = lap; }
+
+    // fill in the size/modified time from disk, after the log is closed
+    void Stat(QDir dir);
+
+    int Duration() { return (first_timestamp <= last_timestamp) ? last_timestamp - first_timestamp : 0; }
+    int TotalRecords();
+
+    QString filename;
+    QDateTime start;
+    QDateTime modified;
+    qint64 size;
+    int first_timestamp; // in ms
+    int last_timestamp; // in ms
+    int laps;
+    int max_rpm;
+    int record_counts[CATALOG_RECORD_TYPES];
+};
+
+QDataStream &operator<<(QDataStream &out, const LogSummary &summary);
+QDataStream &operator>>(QDataStream &in, LogSummary &summary);
+
+// per-log metadata for every log in a directory, kept in a single file so
+// the log list doesn't have to open each log to describe it
+class LogCatalog
+{
+public:
+    LogCatalog();
+
+    void SetDirectory(QDir dir) { directory = dir; }
+
+    bool Load();
+    bool Save();
+
+    // insert or replace the entry for summary.filename
+    void Update(const LogSummary &summary);
+
+    // drop entries for logs that are no longer on disk
+    void Prune();
+
+    // logs on disk the catalog doesn't know about (or whose entry is stale)
+    QStringList Unknown();
+
+    QList<LogSummary> Entries() { return entries; }
+    bool Find(QString filename, LogSummary *summary);
+
+    // builds a summary by reading through a whole log
+    static bool Summarize(QDir dir, QString filename, LogSummary *summary);
+
+    // held around a Load/Update/Save so the logger's writer thread and
+    // the options page never rewrite the catalog at the same time
+    static QMutex *FileLock();
+
+private:
+    QDir directory;
+    QList<LogSummary> entries;
+
+    int IndexOf(QString filename);
+};
+
+// summarizes logs in the background, the results are picked up once
+// the thread has finished
+class CatalogScanner : public QThread
+{
+    Q_OBJECT
+
+public:
+    CatalogScanner(QObject *parent = 0);
+
+    // set up the next scan, ignored while a scan is running
+    void SetFiles(QDir dir, QStringList filenames);
+
+    QList<LogSummary> Results() { return results; }
+
+protected:
+    void run();
+
+private:
+    QDir directory;
+    QStringList files;
+    QList<LogSummary> results;
+};
+
+// folds the summaries of finished logs into the catalog in the
+// background, so closing a log never waits on the catalog being rewritten
+class CatalogWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    CatalogWriter(QObject *parent = 0);
+
+    // queue a summary, the thread is started if it isn't already going
+    void Add(QDir dir, const LogSummary &summary);
+
+protected:
+    void run();
+
+private:
+    QMutex mutex; // guards pending and busy
+    QDir directory;
+    QList<LogSummary> pending;
+    bool busy;
+};
+
+#endif // LOGCATALOG_H
@@ -0,0 +1,309 @@
+#include "LogCopyJob.h"
+
+#ifdef Q_OS_LINUX
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <errno.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <sys/sendfile.h>
+#endif
+
+LogCopyJob::LogCopyJob(QObject *parent)
+    : QThread(parent)
+{
+    cancelled = 0;
+    job_total = 0;
+    job_done = 0;
+    last_percent = -1;
+}
+
+LogCopyJob::~LogCopyJob()
+{
+    // don't pull the rug out from under a running copy
+    Cancel();
+    wait();
+}
+
+void LogCopyJob::SetFiles(QStringList source_files, QDir destination_dir)
+{
+    if (isRunning()) return;
+
+    sources = source_files;
+    destination = destination_dir;
+}
+
+void LogCopyJob::run()
+{
+    int copied = 0;
+    int failed = 0;
+
+    cancelled = 0;
+    job_done = 0;
+    job_total = 0;
+    last_percent = -1;
+    for (int i = 0; i < sources.size(); i++)
+    {
+        job_total += QFileInfo(sources[i]).size();
+    }
+    AddProgress(0);
+
+    for (int i = 0; i < sources.size() && !cancelled; i++)
+    {
+        QString filename = QFileInfo(sources[i]).fileName();
+        QString dest = destination.absoluteFilePath(filename);
+        emit FileStarted(i, sources.size(), filename);
+
+        QString reason;
+        bool created = false;
+        if (CopyOne(sources[i], dest, &reason, &created))
+        {
+            copied++;
+        }
+        else
+        {
+            // don't leave a bad copy lying around on the drive, but
+            // anything that was there before the job stays put
+            if (created) QFile::remove(dest);
+            emit FileFailed(filename, reason);
+            failed++;
+        }
+    }
+
+    emit JobFinished(copied, failed);
+}
+
+bool LogCopyJob::CopyOne(QString src, QString dest, QString *reason, bool *created)
+{
+    *created = false;
+
+    // QFile::copy won't overwrite, so neither do we
+    if (QFile::exists(dest))
+    {
+        *reason = "already exists on the drive";
+        return false;
+    }
+
+    // let the kernel move the bytes if it knows how, otherwise do it ourselves
+    qint64 before = job_done;
+    bool supported = false;
+    bool ok = KernelCopy(src, dest, &supported, created);
+    if (!supported)
+    {
+        job_done = before;
+        ok = ChunkedCopy(src, dest, created);
+    }
+
+    if (cancelled)
+    {
+        *reason = "cancelled";
+        return false;
+    }
+    if (!ok)
+    {
+        *reason = "copy failed";
+        return false;
+    }
+
+    // read the copy back off the drive and compare it to the original
+    SyncToMedia(dest);
+    QByteArray src_sum = Checksum(src);
+    QByteArray dest_sum = Checksum(dest);
+    if (src_sum.isEmpty() || src_sum != dest_sum)
+    {
+        *reason = "copy did not match the original";
+        return false;
+    }
+
+    return true;
+}
+
+bool LogCopyJob::KernelCopy(QString src, QString dest, bool *supported, bool *created)
+{
+    *supported = false;
+
+#if defined(Q_OS_WIN)
+    // CopyFileEx does the copy inside the kernel and calls back with progress
+    file_done = 0;
+    BOOL cancel = FALSE;
+    *supported = true;
+    bool ok = CopyFileExW((const wchar_t *)QDir::toNativeSeparators(src).utf16(),
+                          (const wchar_t *)QDir::toNativeSeparators(dest).utf16(),
+                          CopyProgress, this, &cancel, COPY_FILE_FAIL_IF_EXISTS) != 0;
+
+    // a file that turned up since the check was refused, not ours
+    if (ok || GetLastError() != ERROR_FILE_EXISTS) *created = true;
+    return ok;
+#elif defined(Q_OS_LINUX)
+    int in = open(QFile::encodeName(src).constData(), O_RDONLY);
+    if (in < 0) return false;
+
+    struct stat st;
+    if (fstat(in, &st) < 0)
+    {
+        close(in);
+        return false;
+    }
+
+    int out = open(QFile::encodeName(dest).constData(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (out < 0)
+    {
+        close(in);
+        *supported = true; // the fallback would fail the same way
+        return false;
+    }
+    *created = true;
+
+    // copy_file_range first, sendfile if the kernel or filesystem can't
+    bool use_copy_range = true;
+    bool ok = true;
+    off_t remaining = st.st_size;
+    qint64 copied = 0;
+    while (remaining > 0 && !cancelled)
+    {
+        size_t n = (size_t)qMin((qint64)remaining, (qint64)COPY_CHUNK_SIZE);
+        ssize_t r = -1;
+
+#ifdef SYS_copy_file_range
+        if (use_copy_range)
+        {
+            r = syscall(SYS_copy_file_range, in, NULL, out, NULL, n, 0);
+            if (r < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP))
+            {
+                use_copy_range = false;
+            }
+        }
+#else
+        use_copy_range = false;
+#endif
+        if (!use_copy_range)
+        {
+            r = sendfile(out, in, NULL, n);
+        }
+
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0)
+        {
+            ok = false;
+            break;
+        }
+
+        remaining -= r;
+        copied += r;
+        AddProgress(r);
+    }
+
+    close(in);
+    close(out);
+
+    // neither worked on the very first chunk, so use the fallback
+    if (!ok && copied == 0 && !cancelled)
+    {
+        QFile::remove(dest);
+        *created = false;
+        return false;
+    }
+
+    *supported = true;
+    return ok && !cancelled;
+#else
+    Q_UNUSED(src);
+    Q_UNUSED(dest);
+    Q_UNUSED(created);
+    return false;
+#endif
+}
+
+bool LogCopyJob::ChunkedCopy(QString src, QString dest, bool *created)
+{
+    QFile in(src);
+    QFile out(dest);
+    if (!in.open(QIODevice::ReadOnly)) return false;
+    if (out.exists()) return false;
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    *created = true;
+
+    QByteArray chunk;
+    while (!in.atEnd() && !cancelled)
+    {
+        chunk = in.read(COPY_CHUNK_SIZE);
+        if (chunk.isEmpty()) return false;
+        if (out.write(chunk) != chunk.size()) return false;
+        AddProgress(chunk.size());
+    }
+
+    return !cancelled;
+}
+
+QByteArray LogCopyJob::Checksum(QString filepath)
+{
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    while (!file.atEnd())
+    {
+        QByteArray chunk = file.read(COPY_CHUNK_SIZE);
+        if (chunk.isEmpty()) return QByteArray();
+        hash.addData(chunk);
+    }
+
+    return hash.result();
+}
+
+void LogCopyJob::SyncToMedia(QString filepath)
+{
+    // push the copy out to the drive before it's checked
+#if defined(Q_OS_WIN)
+    // FlushFileBuffers only writes the cached data through to the device,
+    // the pages stay cached so the checksum may well be read back from
+    // memory rather than the drive
+    HANDLE h = CreateFileW((const wchar_t *)QDir::toNativeSeparators(filepath).utf16(),
+                           GENERIC_WRITE, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (h != INVALID_HANDLE_VALUE)
+    {
+        FlushFileBuffers(h);
+        CloseHandle(h);
+    }
+#elif defined(Q_OS_LINUX)
+    int fd = open(QFile::encodeName(filepath).constData(), O_RDONLY);
+    if (fd >= 0)
+    {
+        // and drop it from the page cache so the checksum really does read
+        // it back off the drive
+        fsync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+#else
+    Q_UNUSED(filepath);
+#endif
+}
+
+void LogCopyJob::AddProgress(qint64 bytes)
+{
+    job_done += bytes;
+
+    // only bother the gui when the percentage actually moves
+    int percent = (job_total > 0) ? (int)(job_done * 100 / job_total) : 100;
+    if (percent != last_percent)
+    {
+        last_percent = percent;
+        emit Progress(percent);
+    }
+}
+
+#ifdef Q_OS_WIN
+DWORD CALLBACK LogCopyJob::CopyProgress(LARGE_INTEGER total, LARGE_INTEGER transferred,
+                                        LARGE_INTEGER, LARGE_INTEGER, DWORD, DWORD,
+                                        HANDLE, HANDLE, LPVOID data)
+{
+    Q_UNUSED(total);
+    LogCopyJob *job = (LogCopyJob *)data;
+
+    job->AddProgress(transferred.QuadPart - job->file_done);
+    job->file_done = transferred.QuadPart;
+
+    return (job->cancelled) ? PROGRESS_CANCEL : PROGRESS_CONTINUE;
+}
+#endif
@@ -0,0 +1,72 @@
+#ifndef LOGCOPYJOB_H
+#define LOGCOPYJOB_H
+
+#include <QThread>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QAtomicInt>
+
+#ifdef Q_OS_WIN
+    #include <windows.h>
+#endif
+
+// how much is copied between progress updates (in bytes)
+#define COPY_CHUNK_SIZE (1024 * 1024)
+
+// copies log files to removable media in the background, reporting
+// progress as it goes and checking each copy against its source
+class LogCopyJob : public QThread
+{
+    Q_OBJECT
+
+public:
+    LogCopyJob(QObject *parent = 0);
+    ~LogCopyJob();
+
+    // set up the next job, ignored while a job is running
+    void SetFiles(QStringList source_files, QDir destination_dir);
+
+    // safe from any thread, the copy stops at its next chunk
+    void Cancel() { cancelled.fetchAndStoreRelease(1); }
+
+signals:
+    void FileStarted(int index, int count, QString filename);
+    void Progress(int percent); // of the whole job
+    void FileFailed(QString filename, QString reason);
+    void JobFinished(int copied, int failed);
+
+protected:
+    void run();
+
+private:
+    QStringList sources;
+    QDir destination;
+    QAtomicInt cancelled; // set from the gui thread, read by the copy
+
+    qint64 job_total;
+    qint64 job_done;
+    int last_percent;
+
+    // created is set once the job has made dest itself, so a failed copy
+    // only ever cleans up after itself and never a file already on the drive
+    bool CopyOne(QString src, QString dest, QString *reason, bool *created);
+    bool KernelCopy(QString src, QString dest, bool *supported, bool *created);
+    bool ChunkedCopy(QString src, QString dest, bool *created);
+    QByteArray Checksum(QString filepath);
+    void SyncToMedia(QString filepath);
+    void AddProgress(qint64 bytes);
+
+#ifdef Q_OS_WIN
+    static DWORD CALLBACK CopyProgress(LARGE_INTEGER total, LARGE_INTEGER transferred,
+                                       LARGE_INTEGER, LARGE_INTEGER, DWORD, DWORD,
+                                       HANDLE, HANDLE, LPVOID data);
+    qint64 file_done;
+#endif
+};
+
+#endif // LOGCOPYJOB_H
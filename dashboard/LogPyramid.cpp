@@ -0,0 +1,286 @@
+#include "LogPyramid.h"
+
+static const char *channel_names[PYR_CHANNELS] = {
+    "RPM", "Spark Adv", "MAP", "MAT", "CLT", "TPS", "Battery", "MAF",
+    "Speed", "Altitude", "Heading",
+    "Accel X", "Accel Y", "Accel Z", "Gyro X", "Gyro Y", "Gyro Z"
+};
+
+LogPyramid::LogPyramid()
+{
+    Clear();
+}
+
+const char *LogPyramid::ChannelName(int channel)
+{
+    if (channel < 0 || channel >= PYR_CHANNELS) return "";
+    return channel_names[channel];
+}
+
+void LogPyramid::Clear()
+{
+    for (int c = 0; c < PYR_CHANNELS; c++)
+    {
+        for (int l = 0; l < PYRAMID_LEVELS; l++)
+        {
+            levels[c][l].clear();
+            pending[c][l].count = 0;
+        }
+        samples[c] = 0;
+    }
+}
+
+void LogPyramid::Add(const logrecord_t &record)
+{
+    switch (record.type)
+    {
+    case ECU_RECORD:
+        AddEcu(record.ecu);
+        break;
+    case GPS_RECORD:
+        AddGps(record.gps);
+        break;
+    case IMU_RECORD:
+        AddImu(record.imu);
+        break;
+    }
+}
+
+void LogPyramid::AddEcu(const ecustate_t &state)
+{
+    AddSample(PYR_RPM, state.timestamp, state.rpm);
+    AddSample(PYR_SPARK_ADV, state.timestamp, state.spark_adv);
+    AddSample(PYR_MAP, state.timestamp, state.map);
+    AddSample(PYR_MAT, state.timestamp, state.mat);
+    AddSample(PYR_CLT, state.timestamp, state.clt);
+    AddSample(PYR_TPS, state.timestamp, state.tps);
+    AddSample(PYR_BATT, state.timestamp, state.batt);
+    AddSample(PYR_MAF, state.timestamp, state.maf);
+}
+
+void LogPyramid::AddGps(const gpsstate_t &state)
+{
+    AddSample(PYR_SPEED, state.timestamp, state.speed);
+    AddSample(PYR_ALT, state.timestamp, state.alt);
+    AddSample(PYR_HEADING, state.timestamp, state.heading);
+}
+
+void LogPyramid::AddImu(const imustate_t &state)
+{
+    AddSample(PYR_AX, state.timestamp, state.ax);
+    AddSample(PYR_AY, state.timestamp, state.ay);
+    AddSample(PYR_AZ, state.timestamp, state.az);
+    AddSample(PYR_GX, state.timestamp, state.gx);
+    AddSample(PYR_GY, state.timestamp, state.gy);
+    AddSample(PYR_GZ, state.timestamp, state.gz);
+}
+
+void LogPyramid::AddSample(int channel, int timestamp, double value)
+{
+    samples[channel]++;
+    Accumulate(channel, 0, timestamp, timestamp, value, value, value, 1);
+
+    if (pending[channel][0].count >= SamplesPerBucket(0))
+    {
+        Push(channel, 0);
+    }
+}
+
+void LogPyramid::Accumulate(int channel, int level, int t_start, int t_end, double min, double max, double sum, int count)
+{
+    accumulator_t &acc = pending[channel][level];
+
+    if (acc.count == 0)
+    {
+        acc.t_start = t_start;
+        acc.t_end = t_end;
+        acc.min = min;
+        acc.max = max;
+        acc.sum = sum;
+        acc.samples = count;
+    }
+    else
+    {
+        acc.t_end = t_end;
+        if (min < acc.min) acc.min = min;
+        if (max > acc.max) acc.max = max;
+        acc.sum += sum;
+        acc.samples += count;
+    }
+    acc.count++;
+}
+
+void LogPyramid::Push(int channel, int level)
+{
+    accumulator_t &acc = pending[channel][level];
+
+    pyramidbucket_t bucket;
+    bucket.t_start = acc.t_start;
+    bucket.t_end = acc.t_end;
+    bucket.min = (float)acc.min;
+    bucket.max = (float)acc.max;
+    bucket.mean = (float)(acc.sum / acc.samples);
+    levels[channel][level].append(bucket);
+    acc.count = 0;
+
+    // every two buckets make one bucket on the level above
+    if (level + 1 < PYRAMID_LEVELS)
+    {
+        Accumulate(channel, level + 1, acc.t_start, acc.t_end, acc.min, acc.max, acc.sum, acc.samples);
+        if (pending[channel][level + 1].count >= 2)
+        {
+            Push(channel, level + 1);
+        }
+    }
+}
+
+void LogPyramid::Finish()
+{
+    // close out the partial buckets from the bottom up, each one
+    // feeds into the (possibly partial) bucket above it
+    for (int c = 0; c < PYR_CHANNELS; c++)
+    {
+        for (int l = 0; l < PYRAMID_LEVELS; l++)
+        {
+            if (pending[c][l].count > 0) Push(c, l);
+        }
+    }
+}
+
+bool LogPyramid::Save(QString filepath)
+{
+    QFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_5);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    stream << (quint32)PYRAMID_MAGIC << (qint32)PYR_CHANNELS << (qint32)PYRAMID_LEVELS;
+    for (int c = 0; c < PYR_CHANNELS; c++)
+    {
+        stream << (qint32)samples[c];
+        for (int l = 0; l < PYRAMID_LEVELS; l++)
+        {
+            const QVector<pyramidbucket_t> &buckets = levels[c][l];
+            stream << (qint32)buckets.size();
+            for (int i = 0; i < buckets.size(); i++)
+            {
+                stream << (qint32)buckets[i].t_start << (qint32)buckets[i].t_end;
+                stream << buckets[i].min << buckets[i].max << buckets[i].mean;
+            }
+        }
+    }
+
+    file.close();
+    return stream.status() == QDataStream::Ok;
+}
+
+bool LogPyramid::Load(QString filepath)
+{
+    Clear();
+
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_5);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 magic = 0;
+    qint32 channels = 0, depth = 0;
+    stream >> magic >> channels >> depth;
+    if (magic != PYRAMID_MAGIC || channels != PYR_CHANNELS || depth != PYRAMID_LEVELS) return false;
+
+    for (int c = 0; c < PYR_CHANNELS && stream.status() == QDataStream::Ok; c++)
+    {
+        qint32 count = 0;
+        stream >> count;
+        samples[c] = count;
+        for (int l = 0; l < PYRAMID_LEVELS && stream.status() == QDataStream::Ok; l++)
+        {
+            stream >> count;
+            if (count < 0) return false;
+
+            QVector<pyramidbucket_t> &buckets = levels[c][l];
+            buckets.resize(count);
+            for (int i = 0; i < count; i++)
+            {
+                qint32 t_start, t_end;
+                stream >> t_start >> t_end;
+                stream >> buckets[i].min >> buckets[i].max >> buckets[i].mean;
+                buckets[i].t_start = t_start;
+                buckets[i].t_end = t_end;
+            }
+        }
+    }
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+bool LogPyramid::Build(QString logpath)
+{
+    LogReader reader;
+    if (!reader.Open(logpath)) return false;
+
+    Clear();
+
+    logrecord_t record;
+    while (reader.Next(&record))
+    {
+        Add(record);
+    }
+    Finish();
+
+    return true;
+}
+
+QString LogPyramid::PathFor(QString logpath)
+{
+    if (logpath.endsWith(".ucv", Qt::CaseInsensitive)) logpath.chop(4);
+    return logpath + ".ucp";
+}
+
+int LogPyramid::ChooseLevel(int channel, int t0, int t1, int max_buckets)
+{
+    // the raw samples themselves, if there are few enough of them
+    int first = FindBucket(channel, 0, t0);
+    int last = FindBucket(channel, 0, t1);
+    if ((last - first + 1) * SamplesPerBucket(0) <= max_buckets) return -1;
+
+    for (int l = 0; l < PYRAMID_LEVELS; l++)
+    {
+        first = FindBucket(channel, l, t0);
+        last = FindBucket(channel, l, t1);
+        if (last - first + 1 <= max_buckets) return l;
+    }
+
+    return PYRAMID_LEVELS - 1;
+}
+
+int LogPyramid::FindBucket(int channel, int level, int t)
+{
+    const QVector<pyramidbucket_t> &buckets = levels[channel][level];
+
+    // binary search on the bucket end times
+    int lo = 0;
+    int hi = buckets.size();
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (buckets[mid].t_end < t)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
@@ -0,0 +1,112 @@
+#ifndef LOGPYRAMID_H
+#define LOGPYRAMID_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QDataStream>
+
+#include "LogReader.h"
+#include "ucvtypes.h"
+
+// identifies (and versions) the pyramid file format
+#define PYRAMID_MAGIC 0x55435031 // "UCP1"
+
+// the finest level summarizes 2^PYRAMID_BASE_SHIFT samples per bucket,
+// each level above it summarizes twice as many as the one below
+#define PYRAMID_BASE_SHIFT 4
+#define PYRAMID_LEVELS 12
+
+// channels kept in the pyramid
+enum pyramid_channel_t
+{
+    PYR_RPM = 0,
+    PYR_SPARK_ADV,
+    PYR_MAP,
+    PYR_MAT,
+    PYR_CLT,
+    PYR_TPS,
+    PYR_BATT,
+    PYR_MAF,
+    PYR_SPEED,
+    PYR_ALT,
+    PYR_HEADING,
+    PYR_AX,
+    PYR_AY,
+    PYR_AZ,
+    PYR_GX,
+    PYR_GY,
+    PYR_GZ,
+    PYR_CHANNELS
+};
+
+typedef struct pyramidbucket_struct {
+    int t_start; // timestamp of the first sample, in ms
+    int t_end; // timestamp of the last sample, in ms
+    float min;
+    float max;
+    float mean;
+} pyramidbucket_t;
+
+// min/max/mean overview of every channel of a log at power-of-two
+// resolutions, so a whole run can be drawn by touching one bucket per
+// pixel instead of every sample
+class LogPyramid
+{
+public:
+    LogPyramid();
+
+    static const char *ChannelName(int channel);
+
+    void Clear();
+
+    // add samples in time order, Finish() closes out the partial buckets
+    void Add(const logrecord_t &record);
+    void AddEcu(const ecustate_t &state);
+    void AddGps(const gpsstate_t &state);
+    void AddImu(const imustate_t &state);
+    void AddSample(int channel, int timestamp, double value);
+    void Finish();
+
+    bool Save(QString filepath);
+    bool Load(QString filepath);
+
+    // builds the pyramid for a log that doesn't have one yet
+    bool Build(QString logpath);
+
+    // the pyramid file that goes with a log file
+    static QString PathFor(QString logpath);
+
+    // samples summarized by one bucket at the given level
+    static int SamplesPerBucket(int level) { return 1 << (level + PYRAMID_BASE_SHIFT); }
+
+    int BucketCount(int channel, int level) { return levels[channel][level].size(); }
+    const pyramidbucket_t *Buckets(int channel, int level) { return levels[channel][level].constData(); }
+
+    // the finest level that covers [t0, t1] in no more than max_buckets
+    // buckets, or -1 if even the raw samples would do
+    int ChooseLevel(int channel, int t0, int t1, int max_buckets);
+
+    // index of the first bucket at the level that ends at or after t
+    int FindBucket(int channel, int level, int t);
+
+private:
+    typedef struct accumulator_struct {
+        int count; // samples (or child buckets) accumulated so far
+        int t_start;
+        int t_end;
+        double min;
+        double max;
+        double sum;
+        int samples;
+    } accumulator_t;
+
+    QVector<pyramidbucket_t> levels[PYR_CHANNELS][PYRAMID_LEVELS];
+    accumulator_t pending[PYR_CHANNELS][PYRAMID_LEVELS];
+    int samples[PYR_CHANNELS];
+
+    void Accumulate(int channel, int level, int t_start, int t_end, double min, double max, double sum, int count);
+    void Push(int channel, int level);
+};
+
+#endif // LOGPYRAMID_H
@@ -0,0 +1,218 @@
+#include "LogReader.h"
+
+#include <cstring>
+
+LogReader::LogReader()
+{
+    logfile = NULL;
+    data = NULL;
+    size = 0;
+    pos = 0;
+}
+
+LogReader::~LogReader()
+{
+    Close();
+}
+
+bool LogReader::Open(QString filepath)
+{
+    Close();
+
+    logfile = new QFile(filepath);
+    if (!logfile->open(QIODevice::ReadOnly))
+    {
+        delete logfile;
+        logfile = NULL;
+        return false;
+    }
+
+    size = logfile->size();
+    if (size == 0)
+    {
+        // can't map an empty file, but it's still a valid (empty) log
+        data = (const uchar *)"";
+        return true;
+    }
+
+    // map the whole log, fall back to reading it in if that fails
+    data = logfile->map(0, size);
+    if (data == NULL)
+    {
+        contents = logfile->readAll();
+        data = (const uchar *)contents.constData();
+        size = contents.size();
+    }
+
+    return true;
+}
+
+void LogReader::Close()
+{
+    if (logfile != NULL)
+    {
+        // unmapping happens when the file is closed
+        logfile->close();
+        delete logfile;
+        logfile = NULL;
+    }
+
+    contents.clear();
+    data = NULL;
+    size = 0;
+    pos = 0;
+}
+
+void LogReader::Rewind()
+{
+    pos = 0;
+}
+
+void LogReader::Seek(qint64 offset)
+{
+    pos = qBound((qint64)0, offset, size);
+}
+
+bool LogReader::Next(logrecord_t *record)
+{
+    if (data == NULL || pos >= size) return false;
+
+    quint8 type = data[pos];
+    pos++;
+
+    bool ok = false;
+    switch (type)
+    {
+    case ECU_RECORD:
+        ok = ReadEcu(&record->ecu);
+        break;
+    case GPS_RECORD:
+        ok = ReadGps(&record->gps);
+        break;
+    case IMU_RECORD:
+        ok = ReadImu(&record->imu);
+        break;
+    case LTS_RECORD:
+        ok = ReadLts(&record->lts);
+        break;
+    case LAP_RECORD:
+        ok = ReadLap(&record->lap);
+        break;
+    case LAT_RECORD:
+        ok = ReadLat(&record->lat);
+        break;
+    default:
+        // unknown record type, there's no way to resync after this
+        break;
+    }
+
+    if (!ok)
+    {
+        pos = size;
+        return false;
+    }
+
+    record->type = type;
+    return true;
+}
+
+bool LogReader::ReadEcu(ecustate_t *state)
+{
+    if (size - pos < ECU_RECORD_SIZE) return false;
+
+    state->timestamp = ReadInt32();
+    state->rpm = ReadInt32();
+    state->spark_adv = ReadDouble();
+    state->cranking = ReadBool();
+    state->map = ReadDouble();
+    state->mat = ReadDouble();
+    state->clt = ReadDouble();
+    state->tps = ReadDouble();
+    state->batt = ReadDouble();
+    state->maf = ReadDouble();
+    state->tach_count = ReadInt32();
+    state->acquired = 0;
+    return true;
+}
+
+bool LogReader::ReadGps(gpsstate_t *state)
+{
+    if (size - pos < GPS_RECORD_SIZE) return false;
+
+    state->timestamp = ReadInt32();
+    state->utc_hrs = ReadInt32();
+    state->utc_mins = ReadInt32();
+    state->utc_secs = ReadDouble();
+    state->pos.lat_deg = ReadInt32();
+    state->pos.lat_mins = ReadDouble();
+    state->pos.lat_dir = (gpsdir_t)ReadInt8();
+    state->pos.long_deg = ReadInt32();
+    state->pos.long_mins = ReadDouble();
+    state->pos.long_dir = (gpsdir_t)ReadInt8();
+    state->alt = ReadDouble();
+    state->speed = ReadDouble();
+    state->heading = ReadDouble();
+    state->acquired = 0;
+    return true;
+}
+
+bool LogReader::ReadImu(imustate_t *state)
+{
+    if (size - pos < IMU_RECORD_SIZE) return false;
+
+    state->timestamp = ReadInt32();
+    state->ax = ReadDouble();
+    state->ay = ReadDouble();
+    state->az = ReadDouble();
+    state->gx = ReadDouble();
+    state->gy = ReadDouble();
+    state->gz = ReadDouble();
+    state->acquired = 0;
+    return true;
+}
+
+bool LogReader::ReadLts(ltsstate_t *state)
+{
+    if (size - pos < LTS_RECORD_SIZE) return false;
+
+    state->timestamp = ReadInt32();
+    state->headlights = ReadBool();
+    state->brakelights = ReadBool();
+    state->left_turn = ReadBool();
+    state->right_turn = ReadBool();
+    state->hazards = ReadBool();
+    return true;
+}
+
+bool LogReader::ReadLap(lapevent_t *event)
+{
+    if (size - pos < LAP_RECORD_SIZE) return false;
+
+    event->timestamp = ReadInt32();
+    event->lap = ReadInt32();
+    return true;
+}
+
+bool LogReader::ReadLat(latencyhist_t *hist)
+{
+    if (size - pos < LAT_RECORD_SIZE) return false;
+
+    hist->timestamp = ReadInt32();
+    hist->channel = ReadInt8();
+    hist->kind = ReadInt8();
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        hist->counts[i] = (quint32)ReadInt32();
+    }
+    return true;
+}
+
+double LogReader::ReadDouble()
+{
+    quint64 bits = qFromBigEndian<quint64>(data + pos);
+    pos += 8;
+
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
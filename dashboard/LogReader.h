@@ -0,0 +1,57 @@
+#ifndef LOGREADER_H
+#define LOGREADER_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <QtEndian>
+
+#include "DataLogger.h"
+#include "ucvtypes.h"
+
+// reads back the records written by the DataLogger, one at a time
+// the log file is memory mapped when possible so reading a whole
+// run never copies it through a stream
+class LogReader
+{
+public:
+    LogReader();
+    ~LogReader();
+
+    bool Open(QString filepath);
+    void Close();
+    void Rewind();
+
+    // carry on from an offset that Position() returned earlier
+    void Seek(qint64 offset);
+
+    // decodes the next record, returns false at the end of the log
+    // (a record truncated by a crash or power loss also ends the log)
+    bool Next(logrecord_t *record);
+
+    bool IsOpen() { return data != NULL; }
+    qint64 Size() { return size; }
+    qint64 Position() { return pos; }
+
+private:
+    QFile *logfile;
+    QByteArray contents; // only used if the file couldn't be mapped
+    const uchar *data;
+    qint64 size;
+    qint64 pos;
+
+    bool ReadEcu(ecustate_t *state);
+    bool ReadGps(gpsstate_t *state);
+    bool ReadImu(imustate_t *state);
+    bool ReadLts(ltsstate_t *state);
+    bool ReadLap(lapevent_t *event);
+    bool ReadLat(latencyhist_t *hist);
+
+    // QDataStream writes everything big-endian
+    qint32 ReadInt32() { qint32 v = qFromBigEndian<qint32>(data + pos); pos += 4; return v; }
+    qint8 ReadInt8() { qint8 v = (qint8)data[pos]; pos += 1; return v; }
+    bool ReadBool() { return ReadInt8() != 0; }
+    double ReadDouble();
+};
+
+#endif // LOGREADER_H
@@ -0,0 +1,160 @@
+#include "LogReplay.h"
+
+LogReplay::LogReplay(QObject *parent)
+    : QObject(parent)
+{
+    clock = &wall_clock;
+    speed = 1.0;
+    running = false;
+    have_pending = false;
+    first_timestamp = 0;
+    next_tick = 0;
+
+    timer = new QTimer(this);
+    timer->setInterval(REPLAY_STEP_MS);
+    connect(timer, SIGNAL(timeout()), this, SLOT(Step()));
+}
+
+LogReplay::~LogReplay()
+{
+    // nothing yet
+}
+
+bool LogReplay::Open(QString filepath)
+{
+    Stop();
+
+    if (!reader.Open(filepath)) return false;
+
+    // the first record sets the origin of the replay timeline
+    have_pending = false;
+    first_timestamp = 0;
+    if (Fetch())
+    {
+        first_timestamp = pending.ecu.timestamp;
+    }
+
+    // ticks land on whole seconds of the original run
+    next_tick = (first_timestamp / 1000 + 1) * 1000;
+
+    return true;
+}
+
+void LogReplay::SetClock(ReplayClock *replay_clock)
+{
+    clock = (replay_clock != NULL) ? replay_clock : &wall_clock;
+}
+
+void LogReplay::Start()
+{
+    if (running || !reader.IsOpen()) return;
+
+    running = true;
+    clock->Start();
+    timer->start();
+}
+
+void LogReplay::Stop()
+{
+    if (!running) return;
+
+    timer->stop();
+    running = false;
+}
+
+int LogReplay::RunToEnd()
+{
+    int count = 0;
+
+    while (have_pending)
+    {
+        EmitTicksUntil(pending.ecu.timestamp);
+        Emit(pending);
+        count++;
+        Fetch();
+    }
+
+    Finish();
+    return count;
+}
+
+void LogReplay::Step()
+{
+    if (!have_pending)
+    {
+        Finish();
+        return;
+    }
+
+    if (speed <= REPLAY_MAX_SPEED)
+    {
+        // unthrottled, just emit the next batch
+        for (int i = 0; i < REPLAY_MAX_BATCH && have_pending; i++)
+        {
+            EmitTicksUntil(pending.ecu.timestamp);
+            Emit(pending);
+            Fetch();
+        }
+    }
+    else
+    {
+        // emit everything up to the current point on the scaled timeline
+        int now = first_timestamp + (int)(clock->Elapsed() * speed);
+        while (have_pending && pending.ecu.timestamp <= now)
+        {
+            EmitTicksUntil(pending.ecu.timestamp);
+            Emit(pending);
+            Fetch();
+        }
+        EmitTicksUntil(now);
+    }
+
+    if (!have_pending) Finish();
+}
+
+bool LogReplay::Fetch()
+{
+    have_pending = reader.Next(&pending);
+    return have_pending;
+}
+
+void LogReplay::Emit(const logrecord_t &record)
+{
+    // replayed samples count as acquired the moment they're emitted
+    logrecord_t stamped = record;
+
+    switch (record.type)
+    {
+    case ECU_RECORD:
+        stamped.ecu.acquired = LatencyClock::Now();
+        emit EcuStateChanged(stamped.ecu);
+        break;
+    case GPS_RECORD:
+        stamped.gps.acquired = LatencyClock::Now();
+        emit GpsStateChanged(stamped.gps);
+        break;
+    case IMU_RECORD:
+        stamped.imu.acquired = LatencyClock::Now();
+        emit ImuStateChanged(stamped.imu);
+        break;
+    case LTS_RECORD:
+        emit LtsStateChanged(record.lts);
+        break;
+    }
+}
+
+void LogReplay::EmitTicksUntil(int timestamp)
+{
+    // regenerate the 1 sec timer pulses the original run saw
+    while (next_tick <= timestamp)
+    {
+        emit TmrTick(next_tick);
+        next_tick += 1000;
+    }
+}
+
+void LogReplay::Finish()
+{
+    Stop();
+    emit ReplayFinished();
+}
@@ -0,0 +1,115 @@
+#ifndef LOGREPLAY_H
+#define LOGREPLAY_H
+
+#include <QObject>
+#include <QTime>
+#include <QTimer>
+#include <QString>
+
+#include "LogReader.h"
+#include "LatencyMonitor.h"
+#include "ucvtypes.h"
+
+// replay speed factor meaning "as fast as possible"
+#define REPLAY_MAX_SPEED 0.0
+
+// how often the replay wakes up to emit records (in ms)
+#define REPLAY_STEP_MS 10
+
+// records emitted per step when replaying at max speed, this keeps
+// the event loop (and so the dashboard) responsive during the replay
+#define REPLAY_MAX_BATCH 500
+
+// time source for the replay, swap in a ManualClock to make a replay
+// (and everything hooked up to it) completely deterministic
+class ReplayClock
+{
+public:
+    virtual ~ReplayClock() {}
+    virtual void Start() = 0;
+    virtual int Elapsed() = 0; // in ms since Start()
+};
+
+class WallClock : public ReplayClock
+{
+public:
+    void Start() { time.start(); }
+    int Elapsed() { return time.elapsed(); }
+
+private:
+    QTime time;
+};
+
+class ManualClock : public ReplayClock
+{
+public:
+    ManualClock() { now = 0; }
+    void Start() { now = 0; }
+    int Elapsed() { return now; }
+    void Advance(int ms) { now += ms; }
+
+private:
+    int now;
+};
+
+// plays a recorded log back through the same signals the hardware
+// (and the test harness) emit, so it can drive the dashboard and
+// the data logger exactly like the car does
+class LogReplay : public QObject
+{
+    Q_OBJECT
+
+public:
+    LogReplay(QObject *parent = 0);
+    ~LogReplay();
+
+    bool Open(QString filepath);
+
+    // 1.0 is real time, 2.0 is twice as fast, REPLAY_MAX_SPEED is unthrottled
+    void SetSpeed(double factor) { speed = factor; }
+
+    // the replay does not take ownership of the clock
+    void SetClock(ReplayClock *replay_clock);
+
+    bool IsRunning() { return running; }
+
+    // emits every remaining record without returning to the event loop,
+    // returns the number of records emitted
+    int RunToEnd();
+
+public slots:
+    void Start();
+    void Stop();
+
+    // emits everything that is due according to the clock, called
+    // by the internal timer but can be called directly as well
+    void Step();
+
+signals:
+    void EcuStateChanged(ecustate_t state);
+    void GpsStateChanged(gpsstate_t state);
+    void ImuStateChanged(imustate_t state);
+    void LtsStateChanged(ltsstate_t state);
+    void TmrTick(int ms);
+    void ReplayFinished();
+
+private:
+    LogReader reader;
+    WallClock wall_clock;
+    ReplayClock *clock;
+    QTimer *timer;
+    double speed;
+    bool running;
+
+    logrecord_t pending;
+    bool have_pending;
+    int first_timestamp;
+    int next_tick;
+
+    bool Fetch();
+    void Emit(const logrecord_t &record);
+    void EmitTicksUntil(int timestamp);
+    void Finish();
+};
+
+#endif // LOGREPLAY_H
@@ -8,10 +8,12 @@ Options::Options(QWidget *parent)
 {
     QGroupBox *imu_box = new QGroupBox("IMU Calibration");
     QGroupBox *logfiles_box = new QGroupBox("Data Logging Management");
+    QGroupBox *display_box = new QGroupBox("Display");
     QGroupBox *exitshutdown_box = new QGroupBox("Exit/Shutdown");
 
     QGridLayout *imu_layout = new QGridLayout();
     QGridLayout *logfiles_layout = new QGridLayout();
+    QGridLayout *display_layout = new QGridLayout();
     QGridLayout *exitshutdown_layout = new QGridLayout();
     QGridLayout *layout = new QGridLayout();
 
@@ -31,20 +33,43 @@ Options::Options(QWidget *parent)
     logfiles_explain->setFont(QFont("Fixed", LABEL_FONT_SIZE, QFont::Bold));
     logfiles = new QListWidget();
     logfiles->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
+    logfiles->setSelectionMode(QAbstractItemView::MultiSelection);
     flashdrive_explain = new QLabel("Select a destination drive:");
     flashdrive_explain->setFont(QFont("Fixed", LABEL_FONT_SIZE, QFont::Bold));
     drives = new QListWidget();
     drives->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
     refresh_button = new QPushButton("Refresh");
     refresh_button->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
-    copy_button = new QPushButton("Copy Log File");
+    copy_button = new QPushButton("Copy Log Files");
     copy_button->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
+    copy_progress = new QProgressBar();
+    copy_progress->setRange(0, 100);
+    copy_progress->setValue(0);
+    copy_status = new QLabel("");
+    copy_status->setFont(QFont("Fixed", LABEL_FONT_SIZE, QFont::Bold));
     logfiles_layout->addWidget(logfiles_explain, 0, 0);
     logfiles_layout->addWidget(logfiles, 1, 0);
     logfiles_layout->addWidget(flashdrive_explain, 0, 1);
     logfiles_layout->addWidget(drives, 1, 1);
     logfiles_layout->addWidget(refresh_button, 2, 0);
     logfiles_layout->addWidget(copy_button, 2, 1);
+    logfiles_layout->addWidget(copy_status, 3, 0);
+    logfiles_layout->addWidget(copy_progress, 3, 1);
+
+    // display box
+    paint_stats_label = new QLabel("Repainted: -");
+    paint_stats_label->setFont(QFont("Fixed", LABEL_FONT_SIZE, QFont::Bold));
+    latency_button = new QPushButton("Show Latency");
+    latency_button->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
+    latency_button->setCheckable(true);
+    display_layout->addWidget(paint_stats_label, 0, 0);
+    display_layout->addWidget(latency_button, 0, 1);
+    reference_button = new QPushButton("Use Last Lap as Reference");
+    reference_button->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
+    gate_button = new QPushButton("Set Start/Finish Here");
+    gate_button->setFont(QFont("Fixed", BUTTON_FONT_SIZE, QFont::Bold));
+    display_layout->addWidget(reference_button, 1, 0);
+    display_layout->addWidget(gate_button, 1, 1);
 
     // exit/shutdown box
     exit_button = new QPushButton("Exit to Windows");
@@ -57,12 +82,14 @@ Options::Options(QWidget *parent)
     // master layout
     imu_box->setLayout(imu_layout);
     logfiles_box->setLayout(logfiles_layout);
+    display_box->setLayout(display_layout);
     exitshutdown_box->setLayout(exitshutdown_layout);
     layout->addWidget(title, 0, 0);
     layout->addWidget(close_button, 0, 1);
     layout->addWidget(imu_box, 1, 0, 1, 2);
     layout->addWidget(logfiles_box, 2, 0, 1, 2);
-    layout->addWidget(exitshutdown_box, 3, 0, 1, 2);
+    layout->addWidget(display_box, 3, 0, 1, 2);
+    layout->addWidget(exitshutdown_box, 4, 0, 1, 2);
 
     setLayout(layout);
     setWindowTitle("Options");
@@ -74,13 +101,33 @@ Options::Options(QWidget *parent)
     connect(refresh_button, SIGNAL(clicked()), this, SLOT(RefreshFilesAndDrives()));
     connect(copy_button, SIGNAL(clicked()), this, SLOT(CopyLogfile()));
     connect(zero_button, SIGNAL(clicked()), this, SLOT(ZeroImu()));
+    connect(latency_button, SIGNAL(toggled(bool)), this, SIGNAL(LatencyOverlayToggled(bool)));
+    connect(reference_button, SIGNAL(clicked()), this, SIGNAL(SetReferenceLap()));
+    connect(gate_button, SIGNAL(clicked()), this, SIGNAL(SetStartFinish()));
+
+    // log files are copied in the background so the gui never stalls
+    copy_job = new LogCopyJob(this);
+    connect(copy_job, SIGNAL(FileStarted(int, int, QString)), this, SLOT(CopyFileStarted(int, int, QString)));
+    connect(copy_job, SIGNAL(Progress(int)), copy_progress, SLOT(setValue(int)));
+    connect(copy_job, SIGNAL(FileFailed(QString, QString)), this, SLOT(CopyFileFailed(QString, QString)));
+    connect(copy_job, SIGNAL(JobFinished(int, int)), this, SLOT(CopyFinished(int, int)));
+
+    // logs the catalog doesn't know about yet get summarized in the background
+    scanner = new CatalogScanner(this);
+    connect(scanner, SIGNAL(finished()), this, SLOT(CatalogScanned()));
+
+    // keep an eye on how much of the screen gets repainted
+    paint_stats = new PaintStats(this);
+    connect(paint_stats, SIGNAL(PaintRate(int, int)), this, SLOT(PaintRateUpdated(int, int)));
 
     RefreshFilesAndDrives();
 }
 
 Options::~Options()
 {
-    // nothing yet
+    // a scan still going would be torn down under itself (the copy job
+    // cancels and waits on its own)
+    scanner->wait();
 }
 
 void Options::ShutdownButtonClicked()
@@ -105,30 +152,88 @@ void Options::ShutdownButtonClicked()
 
 void Options::RefreshFilesAndDrives()
 {
-    logfiles->clear();
     drives->clear();
 
-    QDir cwd;
-    QStringList files = cwd.entryList(QStringList("*.ucv"));
-    for (int i = 0; i < files.size(); i++)
-    {
-        logfiles->addItem(files[i]);
-    }
+    // describe the logs from the catalog instead of opening every one
+    catalog.SetDirectory(QDir());
+    catalog.Load();
+    ShowLogfiles();
 
     QFileInfoList drive_list = QDir::drives();
     for (int i = 0; i < drive_list.size(); i++)
     {
         drives->addItem(drive_list.at(i).filePath());
     }
+
+    QStringList unknown = catalog.Unknown();
+    if (!unknown.isEmpty() && !scanner->isRunning())
+    {
+        scanner->SetFiles(QDir(), unknown);
+        scanner->start(QThread::LowPriority);
+    }
+}
+
+void Options::CatalogScanned()
+{
+    // the logger may have updated the catalog in the meantime, so merge
+    // the new summaries into a fresh copy of it
+    QMutexLocker locker(LogCatalog::FileLock());
+    catalog.Load();
+    QList<LogSummary> results = scanner->Results();
+    for (int i = 0; i < results.size(); i++)
+    {
+        catalog.Update(results[i]);
+    }
+    catalog.Prune();
+    catalog.Save();
+
+    ShowLogfiles();
+}
+
+void Options::ShowLogfiles()
+{
+    logfiles->clear();
+
+    QDir cwd;
+    QStringList files = cwd.entryList(QStringList("*.ucv"));
+    for (int i = 0; i < files.size(); i++)
+    {
+        QString text = files[i];
+
+        LogSummary summary;
+        if (catalog.Find(files[i], &summary))
+        {
+            int secs = summary.Duration() / 1000;
+            text = QString("%1  %2:%3  %4 laps  %5 MB")
+                   .arg(summary.start.isValid() ? summary.start.toString("yyyy-MM-dd hh:mm") : files[i])
+                   .arg(secs / 60)
+                   .arg(secs % 60, 2, 10, QChar('0'))
+                   .arg(summary.laps)
+                   .arg(summary.size / (1024.0 * 1024.0), 0, 'f', 1);
+        }
+
+        // the file name rides along with the item for copying
+        QListWidgetItem *item = new QListWidgetItem(text);
+        item->setData(Qt::UserRole, files[i]);
+        logfiles->addItem(item);
+    }
 }
 
 void Options::CopyLogfile()
 {
-    QListWidgetItem *logfile = logfiles->currentItem();
+    // the same button cancels a copy in progress
+    if (copy_job->isRunning())
+    {
+        copy_job->Cancel();
+        copy_status->setText("Cancelling...");
+        return;
+    }
+
+    QList<QListWidgetItem *> selected = logfiles->selectedItems();
     QListWidgetItem *drive = drives->currentItem();
     QMessageBox msg;
 
-    if (logfile == NULL)
+    if (selected.isEmpty())
     {
         msg.setWindowTitle("Error");
         msg.setText("Please select a log file first.");
@@ -145,15 +250,45 @@ void Options::CopyLogfile()
     }
 
     QDir cwd;
-    QString src = cwd.absoluteFilePath(logfile->text());
-    QDir drv(drive->text());
-    QString dest = drv.absoluteFilePath(logfile->text());
+    QStringList sources;
+    for (int i = 0; i < selected.size(); i++)
+    {
+        sources.append(cwd.absoluteFilePath(selected[i]->data(Qt::UserRole).toString()));
+    }
 
-    // copy the file
-    QFile::copy(src, dest);
+    // kick off the copy
+    copy_failures.clear();
+    copy_progress->setValue(0);
+    copy_button->setText("Cancel Copy");
+    copy_job->SetFiles(sources, QDir(drive->text()));
+    copy_job->start(QThread::LowPriority);
+}
 
-    msg.setWindowTitle("Complete");
-    msg.setText(QString("Copied to %1.").arg(dest));
+void Options::CopyFileStarted(int index, int count, QString filename)
+{
+    copy_status->setText(QString("Copying %1 (%2 of %3)").arg(filename).arg(index + 1).arg(count));
+}
+
+void Options::CopyFileFailed(QString filename, QString reason)
+{
+    copy_failures.append(QString("%1: %2").arg(filename).arg(reason));
+}
+
+void Options::CopyFinished(int copied, int failed)
+{
+    copy_button->setText("Copy Log Files");
+
+    if (failed == 0)
+    {
+        copy_status->setText(QString("Copied and verified %1 file(s).").arg(copied));
+        return;
+    }
+
+    copy_status->setText(QString("Copied %1, %2 failed.").arg(copied).arg(failed));
+
+    QMessageBox msg;
+    msg.setWindowTitle("Copy Problems");
+    msg.setText(copy_failures.join("\n"));
     msg.exec();
 }
 
@@ -161,3 +296,11 @@ void Options::ZeroImu()
 {
     g_imu_zero = true;
 }
+
+void Options::PaintRateUpdated(int pixels, int paints)
+{
+    // while the options window is open this label's own repaint is
+    // counted too, a few hundred pixels a second
+    paint_stats_label->setText(QString("Repainted: %1 kpx/s in %2 paints/s")
+                               .arg(pixels / 1000).arg(paints));
+}
@@ -13,12 +13,16 @@
 #include <QFileInfo>
 #include <QMessageBox>
 #include <QFile>
+#include <QProgressBar>
 
 #ifdef RUNNING_IN_CAR
     #include <windows.h>
 #endif
 
 #include "ucvtypes.h"
+#include "LogCopyJob.h"
+#include "LogCatalog.h"
+#include "PaintStats.h"
 
 class Options : public QWidget
 {
@@ -34,11 +38,37 @@ public slots:
     void CopyLogfile();
     void ZeroImu();
 
+    // background copy job progress
+    void CopyFileStarted(int index, int count, QString filename);
+    void CopyFileFailed(QString filename, QString reason);
+    void CopyFinished(int copied, int failed);
+
+    // background catalog rebuild
+    void CatalogScanned();
+
+    // display repaint cost
+    void PaintRateUpdated(int pixels, int paints);
+
+signals:
+    void LatencyOverlayToggled(bool visible);
+    void SetReferenceLap();
+    void SetStartFinish();
+
 private:
-    QLabel *title, *logfiles_explain, *flashdrive_explain, *zero_explain;
+    QLabel *title, *logfiles_explain, *flashdrive_explain, *zero_explain,
+           *copy_status, *paint_stats_label;
     QPushButton *close_button, *exit_button, *shutdown_button,
-                *copy_button, *refresh_button, *zero_button;
+                *copy_button, *refresh_button, *zero_button,
+                *latency_button, *reference_button, *gate_button;
     QListWidget *logfiles, *drives;
+    QProgressBar *copy_progress;
+    LogCopyJob *copy_job;
+    QStringList copy_failures;
+    LogCatalog catalog;
+    CatalogScanner *scanner;
+    PaintStats *paint_stats;
+
+    void ShowLogfiles();
 };
 
 #endif // OPTIONS_H
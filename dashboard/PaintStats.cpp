@@ -0,0 +1,71 @@
+#include "PaintStats.h"
+
+PaintStats::PaintStats(QObject *parent)
+    : QObject(parent)
+{
+    pixels = 0;
+    paints = 0;
+
+    // see every event delivered to any widget
+    qApp->installEventFilter(this);
+
+    timer = new QTimer(this);
+    timer->setInterval(PAINT_STATS_INTERVAL);
+    connect(timer, SIGNAL(timeout()), this, SLOT(Report()));
+    timer->start();
+}
+
+PaintStats::~PaintStats()
+{
+    qApp->removeEventFilter(this);
+}
+
+bool PaintStats::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Paint)
+    {
+        paints++;
+
+        // a see-through child paints over pixels its parent has just
+        // painted (and been counted for), only windows and opaque widgets
+        // have the area they paint taken out of what's underneath
+        QWidget *widget = qobject_cast<QWidget *>(watched);
+        if (widget != NULL && (widget->isWindow() || widget->autoFillBackground() ||
+                               widget->testAttribute(Qt::WA_OpaquePaintEvent)))
+        {
+            pixels += RegionArea(static_cast<QPaintEvent *>(event)->region());
+        }
+    }
+
+    // never swallow the event
+    return QObject::eventFilter(watched, event);
+}
+
+qint64 PaintStats::RegionArea(const QRegion &region)
+{
+    // the region can be several disjoint rectangles (e.g. the old and new
+    // needle positions), so add them up rather than the bounding box
+    // a single rectangle is kept apart from the list, asking for rects()
+    // would build one, more than one shares the region's own
+    if (region.rectCount() == 1)
+    {
+        QRect r = region.boundingRect();
+        return (qint64)r.width() * r.height();
+    }
+
+    qint64 area = 0;
+    const QVector<QRect> rects = region.rects();
+    for (int i = 0; i < rects.size(); i++)
+    {
+        area += (qint64)rects[i].width() * rects[i].height();
+    }
+    return area;
+}
+
+void PaintStats::Report()
+{
+    int scale = 1000 / PAINT_STATS_INTERVAL;
+    emit PaintRate((int)(pixels * scale), paints * scale);
+    pixels = 0;
+    paints = 0;
+}
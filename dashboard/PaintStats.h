@@ -0,0 +1,47 @@
+#ifndef PAINTSTATS_H
+#define PAINTSTATS_H
+
+#include <QObject>
+#include <QEvent>
+#include <QPaintEvent>
+#include <QRegion>
+#include <QVector>
+#include <QRect>
+#include <QTimer>
+#include <QWidget>
+#include <QApplication>
+
+// how often the repaint totals are reported (in ms)
+#define PAINT_STATS_INTERVAL 1000
+
+// watches every paint event in the application and adds up the area
+// actually repainted on screen, so the cost of partial updates can be checked on
+// the (software rendered) car display
+class PaintStats : public QObject
+{
+    Q_OBJECT
+
+public:
+    PaintStats(QObject *parent = 0);
+    ~PaintStats();
+
+protected:
+    virtual bool eventFilter(QObject *watched, QEvent *event);
+
+private slots:
+    void Report();
+
+signals:
+    // repainted pixels and paint events (of every widget) per second
+    // over the last interval
+    void PaintRate(int pixels, int paints);
+
+private:
+    QTimer *timer;
+    qint64 pixels;
+    int paints;
+
+    static qint64 RegionArea(const QRegion &region);
+};
+
+#endif // PAINTSTATS_H
@@ -0,0 +1,245 @@
+#include "ReferenceLap.h"
+
+#include <cmath>
+
+ReferenceLap::ReferenceLap()
+{
+    // a lap at a few fixes a second fits without reallocating
+    points.reserve(1024);
+    min_x = 0.0;
+    min_y = 0.0;
+    cell = REFLAP_CELL_M;
+    cols = 0;
+    rows = 0;
+}
+
+void ReferenceLap::Clear()
+{
+    points.resize(0);
+    xy.resize(0);
+    dist.resize(0);
+    cell_first.resize(0);
+    cell_segments.resize(0);
+    cols = 0;
+    rows = 0;
+}
+
+void ReferenceLap::Add(const gpspos_t &pos, int ms)
+{
+    refpoint_t p;
+    p.lat = LocalProjection::Latitude(pos);
+    p.lon = LocalProjection::Longitude(pos);
+    p.ms = ms;
+    points.append(p);
+}
+
+bool ReferenceLap::Save(QString filepath) const
+{
+    QFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_5);
+
+    stream << (quint32)REFLAP_MAGIC << (qint32)points.size();
+    for (int i = 0; i < points.size(); i++)
+    {
+        stream << points[i].lat << points[i].lon << (qint32)points[i].ms;
+    }
+
+    file.close();
+    return stream.status() == QDataStream::Ok;
+}
+
+bool ReferenceLap::Load(QString filepath)
+{
+    Clear();
+
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_5);
+
+    quint32 magic = 0;
+    qint32 count = 0;
+    stream >> magic >> count;
+    if (magic != REFLAP_MAGIC || count < 0) return false;
+
+    points.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        qint32 ms;
+        stream >> points[i].lat >> points[i].lon >> ms;
+        points[i].ms = ms;
+    }
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+void ReferenceLap::Prepare()
+{
+    xy.resize(0);
+    dist.resize(0);
+    cell_first.resize(0);
+    cell_segments.resize(0);
+    cols = 0;
+    rows = 0;
+    int n = points.size();
+    if (n < 2) return;
+
+    // flatten the lap around its own first point and measure along it
+    projection.SetOrigin(points[0].lat, points[0].lon);
+    xy.resize(n);
+    dist.resize(n);
+    double max_x, max_y;
+    for (int i = 0; i < n; i++)
+    {
+        xy[i] = projection.Project(points[i].lat, points[i].lon);
+        if (i == 0)
+        {
+            dist[i] = 0.0;
+            min_x = max_x = xy[i].x();
+            min_y = max_y = xy[i].y();
+            continue;
+        }
+        double dx = xy[i].x() - xy[i - 1].x();
+        double dy = xy[i].y() - xy[i - 1].y();
+        dist[i] = dist[i - 1] + sqrt(dx * dx + dy * dy);
+        min_x = qMin(min_x, xy[i].x());
+        max_x = qMax(max_x, xy[i].x());
+        min_y = qMin(min_y, xy[i].y());
+        max_y = qMax(max_y, xy[i].y());
+    }
+
+    cell = REFLAP_CELL_M;
+    while (((max_x - min_x) / cell + 1) * ((max_y - min_y) / cell + 1) > REFLAP_MAX_CELLS)
+    {
+        cell *= 2;
+    }
+    cols = (int)((max_x - min_x) / cell) + 1;
+    rows = (int)((max_y - min_y) / cell) + 1;
+
+    // count the segments in each cell, then fill them in behind the
+    // running totals so every cell's list is contiguous
+    cell_first.fill(0, cols * rows + 1);
+    for (int i = 0; i < n - 1; i++)
+    {
+        int c0, r0, c1, r1;
+        CellRange(i, &c0, &r0, &c1, &r1);
+        for (int r = r0; r <= r1; r++)
+        {
+            for (int c = c0; c <= c1; c++)
+            {
+                cell_first[r * cols + c + 1]++;
+            }
+        }
+    }
+    for (int c = 0; c < cols * rows; c++)
+    {
+        cell_first[c + 1] += cell_first[c];
+    }
+
+    QVector<int> next = cell_first;
+    cell_segments.resize(cell_first.last());
+    for (int i = 0; i < n - 1; i++)
+    {
+        int c0, r0, c1, r1;
+        CellRange(i, &c0, &r0, &c1, &r1);
+        for (int r = r0; r <= r1; r++)
+        {
+            for (int c = c0; c <= c1; c++)
+            {
+                cell_segments[next[r * cols + c]++] = i;
+            }
+        }
+    }
+}
+
+void ReferenceLap::CellRange(int segment, int *c0, int *r0, int *c1, int *r1) const
+{
+    const QPointF &a = xy[segment];
+    const QPointF &b = xy[segment + 1];
+    *c0 = (int)((qMin(a.x(), b.x()) - min_x) / cell);
+    *c1 = (int)((qMax(a.x(), b.x()) - min_x) / cell);
+    *r0 = (int)((qMin(a.y(), b.y()) - min_y) / cell);
+    *r1 = (int)((qMax(a.y(), b.y()) - min_y) / cell);
+}
+
+bool ReferenceLap::Locate(const gpspos_t &pos, double hint, reflocation_t *where) const
+{
+    if (cols == 0) return false;
+
+    QPointF p = projection.Project(pos);
+    int pc = (int)floor((p.x() - min_x) / cell);
+    int pr = (int)floor((p.y() - min_y) / cell);
+
+    // nearest segment overall, and nearest within reach of the hint
+    // (anything within a cell of the fix touches one of the 3x3 cells)
+    double limit = cell * cell;
+    double near_d2 = limit, far_d2 = limit;
+    int near_seg = -1, far_seg = -1;
+    double near_t = 0.0, far_t = 0.0;
+
+    for (int r = pr - 1; r <= pr + 1; r++)
+    {
+        if (r < 0 || r >= rows) continue;
+        for (int c = pc - 1; c <= pc + 1; c++)
+        {
+            if (c < 0 || c >= cols) continue;
+
+            int cell_index = r * cols + c;
+            for (int k = cell_first[cell_index]; k < cell_first[cell_index + 1]; k++)
+            {
+                int i = cell_segments[k];
+                const QPointF &a = xy[i];
+                const QPointF &b = xy[i + 1];
+
+                // closest point on the segment
+                double sx = b.x() - a.x();
+                double sy = b.y() - a.y();
+                double len2 = sx * sx + sy * sy;
+                double t = 0.0;
+                if (len2 > 0.0)
+                {
+                    t = ((p.x() - a.x()) * sx + (p.y() - a.y()) * sy) / len2;
+                    t = qBound(0.0, t, 1.0);
+                }
+                double dx = a.x() + t * sx - p.x();
+                double dy = a.y() + t * sy - p.y();
+                double d2 = dx * dx + dy * dy;
+
+                double along = dist[i] + t * (dist[i + 1] - dist[i]);
+                if (hint < 0.0 || fabs(along - hint) <= REFLAP_MAX_JUMP_M)
+                {
+                    if (d2 < near_d2)
+                    {
+                        near_d2 = d2;
+                        near_seg = i;
+                        near_t = t;
+                    }
+                }
+                else if (d2 < far_d2)
+                {
+                    far_d2 = d2;
+                    far_seg = i;
+                    far_t = t;
+                }
+            }
+        }
+    }
+
+    int i = (near_seg >= 0) ? near_seg : far_seg;
+    if (i < 0) return false;
+    double t = (near_seg >= 0) ? near_t : far_t;
+
+    where->distance = dist[i] + t * (dist[i + 1] - dist[i]);
+    where->offset = sqrt((near_seg >= 0) ? near_d2 : far_d2);
+    where->ms = points[i].ms + (int)(t * (points[i + 1].ms - points[i].ms));
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef REFERENCELAP_H
+#define REFERENCELAP_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QPointF>
+#include <QDataStream>
+
+#include "ucvtypes.h"
+#include "LocalProjection.h"
+
+// identifies (and versions) the reference lap file format
+#define REFLAP_MAGIC 0x55435231 // "UCR1"
+
+// where the reference lap is kept, next to the logs
+#define REFLAP_FILENAME "reference.lap"
+
+// side of a cell of the spatial index (in m), big tracks get bigger cells
+// so the index never has more than REFLAP_MAX_CELLS of them
+#define REFLAP_CELL_M 25.0
+#define REFLAP_MAX_CELLS 65536
+
+// matches further than this along the lap from the previous one are only
+// used when nothing nearer turns up (in m), so where the start and finish
+// overlap (or the track crosses itself) the position doesn't jump around
+#define REFLAP_MAX_JUMP_M 150.0
+
+typedef struct refpoint_struct {
+    double lat; // in signed degrees (north positive)
+    double lon; // in signed degrees (east positive)
+    int ms; // since the start of the lap
+} refpoint_t;
+
+// where a position falls on the reference lap
+typedef struct reflocation_struct {
+    double distance; // along the lap from its start (in m)
+    double offset; // away from the reference line (in m)
+    int ms; // reference lap time at that distance
+} reflocation_t;
+
+// the gps trace of one lap, kept in degrees so it doesn't depend on
+// whichever projection it ends up drawn with
+// once prepared the lap is also a polyline parameterized by distance with
+// a uniform grid of the segments crossing each cell, so finding where a
+// fix falls on the lap only looks at the segments in the 3x3 cells around
+// it, and doesn't allocate
+class ReferenceLap
+{
+public:
+    ReferenceLap();
+
+    void Clear();
+    void Add(const gpspos_t &pos, int ms);
+
+    bool IsEmpty() const { return points.isEmpty(); }
+    int Size() const { return points.size(); }
+    const refpoint_t &Point(int i) const { return points[i]; }
+
+    // build the distances and the index, after the last Add or a Load
+    void Prepare();
+    double Length() const { return dist.isEmpty() ? 0.0 : dist.last(); }
+    int LapMs() const { return points.isEmpty() ? 0 : points.last().ms; }
+
+    // hint is the distance of the previous match (negative for none),
+    // false if the lap isn't prepared or the fix is more than a cell away
+    bool Locate(const gpspos_t &pos, double hint, reflocation_t *where) const;
+
+    bool Save(QString filepath) const;
+    bool Load(QString filepath);
+
+private:
+    QVector<refpoint_t> points;
+
+    // set up by Prepare
+    LocalProjection projection;
+    QVector<QPointF> xy; // in m
+    QVector<double> dist; // along the lap to each point (in m)
+    double min_x, min_y; // corner of the index (in m)
+    double cell; // in m
+    int cols, rows;
+    QVector<int> cell_first; // cell c holds cell_segments[cell_first[c]..cell_first[c + 1]]
+    QVector<int> cell_segments; // segment i runs from point i to i + 1
+
+    void CellRange(int segment, int *c0, int *r0, int *c1, int *r1) const;
+};
+
+#endif // REFERENCELAP_H
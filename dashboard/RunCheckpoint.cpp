@@ -0,0 +1,103 @@
+#include "RunCheckpoint.h"
+
+#include <cstring>
+
+RunCheckpoint::RunCheckpoint()
+{
+    map = NULL;
+    data = NULL;
+    seq = 0;
+}
+
+RunCheckpoint::~RunCheckpoint()
+{
+    Close();
+}
+
+bool RunCheckpoint::Open(QString filepath)
+{
+    Close();
+
+    file.setFileName(filepath);
+    if (!file.open(QIODevice::ReadWrite)) return false;
+    if (file.size() != sizeof(runcheckpointfile_t) && !file.resize(sizeof(runcheckpointfile_t)))
+    {
+        file.close();
+        return false;
+    }
+
+    map = file.map(0, sizeof(runcheckpointfile_t));
+    if (map == NULL)
+    {
+        file.close();
+        return false;
+    }
+    data = (runcheckpointfile_t *)map;
+
+    // anything else gets wiped
+    if (data->magic != RUNCKPT_MAGIC || data->state_size != sizeof(runstate_t))
+    {
+        memset(map, 0, sizeof(runcheckpointfile_t));
+        data->magic = RUNCKPT_MAGIC;
+        data->state_size = sizeof(runstate_t);
+    }
+
+    // carry on numbering from the newest copy
+    seq = qMax(data->copies[0].seq, data->copies[1].seq);
+    if (seq < 0) seq = 0;
+    return true;
+}
+
+void RunCheckpoint::Close()
+{
+    if (map == NULL) return;
+
+    file.unmap(map);
+    file.close();
+    map = NULL;
+    data = NULL;
+}
+
+void RunCheckpoint::Save(const runstate_t &state)
+{
+    if (data == NULL) return;
+
+    seq++;
+    runstatecopy_t *copy = &data->copies[seq & 1];
+    ((QAtomicInt *)&copy->seq)->fetchAndStoreRelease(-1);
+    memcpy(&copy->state, &state, sizeof(state));
+    ((QAtomicInt *)&copy->seq)->fetchAndStoreRelease(seq);
+}
+
+bool RunCheckpoint::Load(runstate_t *state) const
+{
+    if (data == NULL) return false;
+
+    int newest = (data->copies[0].seq > data->copies[1].seq) ? 0 : 1;
+    if (data->copies[newest].seq <= 0) return false;
+
+    memcpy(state, &data->copies[newest].state, sizeof(*state));
+    return true;
+}
+
+qint64 RunCheckpoint::LocalOrigin(const runstate_t &state)
+{
+    qint64 now = LatencyClock::Now();
+    qint64 by_system = now + LatencyClock::SystemOffset() - state.origin_system_us;
+    qint64 by_wall = (QDateTime::currentMSecsSinceEpoch() - state.origin_wall_ms) * 1000;
+
+    // trust the monotonic clock unless it was reset under us
+    qint64 elapsed = by_system;
+    if (qAbs(by_system - by_wall) > RUNCKPT_CLOCK_SLACK_MS * 1000LL)
+    {
+        elapsed = by_wall;
+    }
+    return now - elapsed;
+}
+
+void RunCheckpoint::SetOrigin(runstate_t *state, qint64 origin_us)
+{
+    qint64 ago_ms = (LatencyClock::Now() - origin_us) / 1000;
+    state->origin_system_us = origin_us + LatencyClock::SystemOffset();
+    state->origin_wall_ms = QDateTime::currentMSecsSinceEpoch() - ago_ms;
+}
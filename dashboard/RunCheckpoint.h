@@ -0,0 +1,81 @@
+#ifndef RUNCHECKPOINT_H
+#define RUNCHECKPOINT_H
+
+#include <QFile>
+#include <QString>
+#include <QAtomicInt>
+#include <QDateTime>
+
+#include "LatencyMonitor.h"
+
+// identifies (and versions) the checkpoint file format
+#define RUNCKPT_MAGIC 0x55434b31 // "UCK1"
+
+// where the run checkpoint lives, next to the logs
+#define RUNCKPT_FILENAME "run.ckpt"
+
+// room for this many laps (has to be at least NUMBER_OF_LAPS)
+#define RUNCKPT_MAX_LAPS 16
+
+// if the monotonic and the wall clock disagree by more than this (in ms)
+// about how long the run has been going, the monotonic clock restarted
+// (the machine rebooted) and the wall clock is used instead
+#define RUNCKPT_CLOCK_SLACK_MS 2000
+
+// everything needed to pick a run back up
+typedef struct runstate_struct {
+    qint32 running;
+    qint32 current_lap;
+    qint32 lap_ms[RUNCKPT_MAX_LAPS]; // run time each lap was completed at (in ms)
+    qint32 lap_start_ms;
+    qint32 avgspeed_denominator;
+    double avgspeed_numerator;
+    qint64 origin_system_us; // run time 0 on the system monotonic clock
+    qint64 origin_wall_ms; // run time 0 in ms since the epoch
+} runstate_t;
+
+typedef struct runstatecopy_struct {
+    qint32 seq; // -1 while being written, 0 for never
+    qint32 reserved;
+    runstate_t state;
+} runstatecopy_t;
+
+typedef struct runcheckpointfile_struct {
+    quint32 magic;
+    quint32 state_size;
+    runstatecopy_t copies[2];
+} runcheckpointfile_t;
+
+// the state of the run in a small memory mapped file, saved on every change
+// saves alternate between two copies, each one's sequence number is cleared
+// before it's written and set after, so a process dying halfway through a
+// save always leaves the other copy whole, and the page cache keeps the
+// file for the restarted process without any writes or flushes here
+class RunCheckpoint
+{
+public:
+    RunCheckpoint();
+    ~RunCheckpoint();
+
+    bool Open(QString filepath);
+    void Close();
+
+    void Save(const runstate_t &state);
+
+    // the newest whole copy, false if there's none
+    bool Load(runstate_t *state) const;
+
+    // LatencyClock time of a saved run's origin in this process (in us)
+    static qint64 LocalOrigin(const runstate_t &state);
+
+    // fill in the origin fields for a run starting at a LatencyClock time
+    static void SetOrigin(runstate_t *state, qint64 origin_us);
+
+private:
+    QFile file;
+    uchar *map;
+    runcheckpointfile_t *data;
+    int seq;
+};
+
+#endif // RUNCHECKPOINT_H
@@ -0,0 +1,82 @@
+#include "RunClock.h"
+
+#include <QCoreApplication>
+#include <QPointer>
+
+RunClock *RunClock::instance()
+{
+    // owned by the application so it's gone before statics are torn
+    // down, a QPointer so nothing is handed out after that
+    static QPointer<RunClock> clock;
+    if (clock.isNull()) clock = new RunClock();
+    return clock;
+}
+
+RunClock::RunClock()
+    : QObject(qApp)
+{
+    running = false;
+    origin = 0;
+    next_tick = 0;
+
+    timer.setSingleShot(true);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(Deadline()));
+}
+
+void RunClock::Start()
+{
+    StartAt(LatencyClock::Now());
+}
+
+void RunClock::StartAt(qint64 origin_us)
+{
+    origin = origin_us;
+    running = true;
+
+    // a backdated start may already be past a tick or two
+    next_tick = RUNCLOCK_TICK_MS;
+    while (next_tick <= Elapsed()) next_tick += RUNCLOCK_TICK_MS;
+    Schedule();
+}
+
+void RunClock::Stop()
+{
+    running = false;
+    timer.stop();
+}
+
+int RunClock::Elapsed() const
+{
+    if (!running) return 0;
+    return ElapsedAt(LatencyClock::Now());
+}
+
+int RunClock::ElapsedAt(qint64 us) const
+{
+    return (int)((us - origin) / 1000);
+}
+
+void RunClock::Schedule()
+{
+    timer.start(qMax(next_tick - Elapsed(), 0));
+}
+
+void RunClock::Deadline()
+{
+    if (!running) return;
+
+    // timers can fire a little early, just wait out the rest
+    int now = Elapsed();
+    if (now < next_tick)
+    {
+        Schedule();
+        return;
+    }
+
+    // report the deadline itself, then skip any we were too busy to make
+    int due = next_tick;
+    while (next_tick <= now) next_tick += RUNCLOCK_TICK_MS;
+    Schedule();
+
+    emit Tick(due);
+}
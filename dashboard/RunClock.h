@@ -0,0 +1,57 @@
+#ifndef RUNCLOCK_H
+#define RUNCLOCK_H
+
+#include <QObject>
+#include <QTimer>
+
+#include "LatencyMonitor.h"
+
+// time between run timer ticks (in ms)
+#define RUNCLOCK_TICK_MS 1000
+
+// monotonic clock for the run, counted from an origin on LatencyClock
+// ticks are scheduled against absolute deadlines (origin + n seconds)
+// rather than "a second after the last one fired", so a late tick never
+// pushes the ones after it back and the run time doesn't drift
+// anything that wants the exact time of an event (a button press, a
+// crossing) asks for Elapsed() then and there instead of waiting for a tick
+class RunClock : public QObject
+{
+    Q_OBJECT
+
+public:
+    static RunClock *instance();
+
+    // start now, or from an earlier moment on LatencyClock (in us)
+    void Start();
+    void StartAt(qint64 origin_us);
+    void Stop();
+
+    bool IsRunning() const { return running; }
+    qint64 Origin() const { return origin; }
+
+    // ms since the run started, 0 when it isn't running
+    int Elapsed() const;
+
+    // run time of a LatencyClock reading (in us), e.g. a sample's acquired time
+    int ElapsedAt(qint64 us) const;
+
+signals:
+    // every RUNCLOCK_TICK_MS, with the deadline that was due (in ms)
+    void Tick(int ms);
+
+private slots:
+    void Deadline();
+
+private:
+    RunClock();
+
+    QTimer timer;
+    bool running;
+    qint64 origin; // in us on LatencyClock
+    int next_tick; // in ms since the origin
+
+    void Schedule();
+};
+
+#endif // RUNCLOCK_H
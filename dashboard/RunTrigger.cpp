@@ -0,0 +1,81 @@
+#include "RunTrigger.h"
+
+RunTrigger::RunTrigger(QObject *parent)
+    : QObject(parent)
+{
+    armed = false;
+    rpm_threshold = RUNTRIGGER_RPM;
+    speed_threshold = RUNTRIGGER_SPEED;
+    last_rpm = 0;
+    last_rpm_us = 0;
+    last_speed = 0.0;
+    last_speed_us = 0;
+}
+
+void RunTrigger::SetThresholds(int rpm, double speed)
+{
+    rpm_threshold = rpm;
+    speed_threshold = speed;
+}
+
+void RunTrigger::SetArmed(bool arm)
+{
+    armed = arm;
+
+    // only crossings from here on count
+    last_rpm_us = 0;
+    last_speed_us = 0;
+}
+
+void RunTrigger::EcuUpdate(ecustate_t state)
+{
+    if (!armed) return;
+
+    qint64 us = (state.acquired != 0) ? state.acquired : LatencyClock::Now();
+    qint64 at_us;
+    if (Crossed(last_rpm, last_rpm_us, state.rpm, us, rpm_threshold, &at_us))
+    {
+        armed = false;
+        emit Triggered(at_us);
+        return;
+    }
+
+    last_rpm = state.rpm;
+    last_rpm_us = us;
+}
+
+void RunTrigger::GpsUpdate(gpsstate_t state)
+{
+    if (!armed) return;
+
+    qint64 us = (state.acquired != 0) ? state.acquired : LatencyClock::Now();
+    qint64 at_us;
+    if (Crossed(last_speed, last_speed_us, state.speed, us, speed_threshold, &at_us))
+    {
+        armed = false;
+        emit Triggered(at_us);
+        return;
+    }
+
+    last_speed = state.speed;
+    last_speed_us = us;
+}
+
+bool RunTrigger::Crossed(double before, qint64 before_us, double after, qint64 after_us,
+                         double threshold, qint64 *at_us)
+{
+    // it has to go from under to over while armed, so arming with the
+    // engine already revving (or the car already rolling) waits for it
+    // to drop back first
+    if (before_us == 0 || before >= threshold || after < threshold) return false;
+    if (after_us <= before_us)
+    {
+        *at_us = after_us;
+        return true;
+    }
+
+    // straight line between the two samples
+    double fraction = (threshold - before) / (after - before);
+    *at_us = before_us + (qint64)(fraction * (after_us - before_us));
+    return true;
+}
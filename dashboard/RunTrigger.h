@@ -0,0 +1,52 @@
+#ifndef RUNTRIGGER_H
+#define RUNTRIGGER_H
+
+#include <QObject>
+
+#include "ucvtypes.h"
+#include "LatencyMonitor.h"
+
+// default thresholds that start an armed run, whichever comes first
+#define RUNTRIGGER_RPM 2000
+#define RUNTRIGGER_SPEED 2.0 // in mph
+
+// starts the run by itself once the engine or the car gets going
+// while armed it watches the ecu and gps states straight off the parser and
+// looks for the pair of samples that straddle a threshold, the start time
+// is interpolated between their acquired times so the run clock starts
+// when the threshold was actually crossed, not when the sample arrived
+class RunTrigger : public QObject
+{
+    Q_OBJECT
+
+public:
+    RunTrigger(QObject *parent = 0);
+
+    void SetThresholds(int rpm, double speed);
+    bool IsArmed() const { return armed; }
+
+public slots:
+    void SetArmed(bool arm);
+    void EcuUpdate(ecustate_t state);
+    void GpsUpdate(gpsstate_t state);
+
+signals:
+    // the run started at this time on LatencyClock (in us)
+    void Triggered(qint64 origin_us);
+
+private:
+    bool armed;
+    int rpm_threshold;
+    double speed_threshold;
+
+    // last sample seen of each, 0 acquired time for none yet
+    int last_rpm;
+    qint64 last_rpm_us;
+    double last_speed;
+    qint64 last_speed_us;
+
+    bool Crossed(double before, qint64 before_us, double after, qint64 after_us,
+                 double threshold, qint64 *at_us);
+};
+
+#endif // RUNTRIGGER_H
@@ -0,0 +1,249 @@
+#include "SensorParser.h"
+
+#include <cstring>
+
+SensorParser::SensorParser(QObject *parent)
+    : QObject(parent),
+      dollar("\\$"),
+      ggare("^\\$GPGGA,([0-9.]+),([0-9.]+),(N|S),([0-9.]+),(W|E),([0-9]),[0-9]+,[0-9.]+,([0-9.]+),"),
+      vtgre("^\\$GPVTG,([0-9.]+),[^,]*,[^,]*,[^,]*,[0-9.]+,[^,]*,([0-9.]+)"),
+      imumsg("^\\$([0-9]{4})\\s+([0-9]{4})\\s+([0-9]{4})\\s+([0-9]{4})\\s+([0-9]{4})\\s+([0-9]{4})")
+{
+    memset(&ecu_state, 0, sizeof(ecu_state));
+    memset(&gps_state, 0, sizeof(gps_state));
+    memset(&imu_state, 0, sizeof(imu_state));
+    ecu_bytes = 0;
+    gps_lock_state = 0;
+    imu_zero = false;
+    neutral_ax = IMU_DEFAULT_AX;
+    neutral_ay = IMU_DEFAULT_AY;
+    neutral_az = IMU_DEFAULT_AZ;
+    neutral_gx = IMU_DEFAULT_GX;
+    neutral_gy = IMU_DEFAULT_GY;
+    neutral_gz = IMU_DEFAULT_GZ;
+}
+
+SensorParser::~SensorParser()
+{
+    // nothing yet
+}
+
+void SensorParser::EcuRequest()
+{
+    ecu_bytes = 0;
+}
+
+void SensorParser::FeedEcu(const char *buf, int len, int timestamp)
+{
+    // save the bytes read, anything past the end of the block is ignored
+    int n = qMin(len, ECU_BLOCK_SIZE - ecu_bytes);
+    if (n <= 0) return;
+    memcpy(ecu_block + ecu_bytes, buf, n);
+    ecu_bytes += n;
+
+    if (ecu_bytes >= ECU_BLOCK_SIZE)
+    {
+        ParseEcuBlock(timestamp);
+        ecu_bytes = 0;
+    }
+}
+
+void SensorParser::ParseEcuBlock(int timestamp)
+{
+    // more information about the serial protocol
+    // for communicating with the MegaSquirt II
+    // ECU can be found here:
+    // http://www.megamanual.com/ms2/code.htm
+    // (MegaSquirt is big-endian)
+    const uchar *data = (const uchar *)ecu_block;
+
+    ecu_state.rpm = qFromBigEndian<quint16>(data + 6);
+    ecu_state.spark_adv = qFromBigEndian<qint16>(data + 8) / 10.0;
+
+    unsigned char engine = data[11];
+    ecu_state.cranking = (engine & (1 << 1));
+
+    ecu_state.map = qFromBigEndian<qint16>(data + 18) / 10.0;
+    ecu_state.mat = qFromBigEndian<qint16>(data + 20) / 10.0;
+    ecu_state.clt = qFromBigEndian<qint16>(data + 22) / 10.0;
+    ecu_state.tps = qFromBigEndian<qint16>(data + 24) / 10.0;
+    ecu_state.batt = qFromBigEndian<qint16>(data + 26) / 10.0;
+    ecu_state.maf = qFromBigEndian<quint16>(data + 64) / 10.0;
+    ecu_state.tach_count = qFromBigEndian<quint16>(data + 104);
+
+    ecu_state.timestamp = timestamp;
+    ecu_state.acquired = LatencyClock::Now();
+
+    emit EcuStateChanged(ecu_state);
+}
+
+void SensorParser::FeedGps(const char *buf, int len, int timestamp)
+{
+    int pos = 0;
+    bool state_changed = false;
+
+    gps_buffer.append(buf, len);
+
+    // make sure the buffer starts with the first dollar sign
+    pos = dollar.indexIn(gps_buffer);
+    if (pos >= 0)
+    {
+        // shift the buffer to align it with the beginning of the message
+        gps_buffer = gps_buffer.mid(pos);
+    }
+
+    // search for a GGA message match
+    pos = ggare.indexIn(gps_buffer);
+    if (pos >= 0)
+    {
+        QString utc_time = ggare.cap(1);
+        QString latitude = ggare.cap(2);
+        QString lat_ns = ggare.cap(3);
+        QString longitude = ggare.cap(4);
+        QString long_ew = ggare.cap(5);
+        QString gps_lock = ggare.cap(6);
+        QString altitude = ggare.cap(7);
+
+        bool ok = false;
+        gps_state.utc_hrs = utc_time.mid(0, 2).toInt(&ok);
+        gps_state.utc_mins = utc_time.mid(2, 2).toInt(&ok);
+        gps_state.utc_secs = utc_time.mid(4, 6).toDouble(&ok);
+        if (latitude.length() == 9)
+        {
+            gps_state.pos.lat_deg = latitude.mid(0, 2).toInt(&ok);
+            gps_state.pos.lat_mins = latitude.mid(2).toDouble(&ok);
+        }
+        else
+        {
+            gps_state.pos.lat_deg = latitude.mid(0, 3).toInt(&ok);
+            gps_state.pos.lat_mins = latitude.mid(3).toDouble(&ok);
+        }
+        gps_state.pos.lat_dir = lat_ns.at(0).toAscii();
+        if (longitude.length() == 9)
+        {
+            gps_state.pos.long_deg = longitude.mid(0, 2).toInt(&ok);
+            gps_state.pos.long_mins = longitude.mid(2).toDouble(&ok);
+        }
+        else
+        {
+            gps_state.pos.long_deg = longitude.mid(0, 3).toInt(&ok);
+            gps_state.pos.long_mins = longitude.mid(3).toDouble(&ok);
+        }
+        gps_state.pos.long_dir = long_ew.at(0).toAscii();
+        gps_state.alt = altitude.toDouble(&ok);
+        gps_state.timestamp = timestamp;
+        state_changed = true;
+
+        // check the lock state
+        int cur_lock_state = gps_lock.toInt(&ok);
+        if (cur_lock_state != gps_lock_state)
+        {
+            // state changed, let the hardware update the status led
+            gps_lock_state = cur_lock_state;
+            emit GpsLockChanged(gps_lock_state != 0);
+        }
+
+        // shift the buffer down
+        gps_buffer = gps_buffer.mid(pos + ggare.matchedLength());
+    }
+
+    // search for a VTG match
+    pos = vtgre.indexIn(gps_buffer);
+    if (pos >= 0)
+    {
+        QString heading = vtgre.cap(1);
+        QString speed = vtgre.cap(2);
+
+        bool ok = false;
+        gps_state.heading = heading.toDouble(&ok);
+        gps_state.speed = speed.toDouble(&ok) * 0.621371192; // convert km/h to mph
+        gps_state.timestamp = timestamp;
+        state_changed = true;
+
+        // shift the buffer down
+        gps_buffer = gps_buffer.mid(pos + vtgre.matchedLength());
+    }
+
+    if (state_changed)
+    {
+        // update anybody listening
+        gps_state.acquired = LatencyClock::Now();
+        emit GpsStateChanged(gps_state);
+    }
+}
+
+void SensorParser::FeedImu(const char *buf, int len, int timestamp)
+{
+    int pos = 0;
+    bool zeroed = false;
+
+    imu_buffer.append(buf, len);
+
+    // make sure the buffer starts with the first dollar sign
+    pos = dollar.indexIn(imu_buffer);
+    if (pos >= 0)
+    {
+        // shift the buffer to align it with the beginning of the message
+        imu_buffer = imu_buffer.mid(pos);
+    }
+
+    // search for an imu message match
+    pos = imumsg.indexIn(imu_buffer);
+    if (pos >= 0)
+    {
+        // refer to mainboard schematic, imu microcontroller just outputs
+        // the numbers in channel order 0-6
+        QString gy_str = imumsg.cap(1);
+        QString gx_str = imumsg.cap(2);
+        QString gz_str = imumsg.cap(3);
+        QString az_str = imumsg.cap(4);
+        QString ay_str = imumsg.cap(5);
+        QString ax_str = imumsg.cap(6);
+
+        bool ok = false;
+        int iax = ax_str.toInt(&ok);
+        int iay = ay_str.toInt(&ok);
+        int iaz = az_str.toInt(&ok);
+        int igx = gx_str.toInt(&ok);
+        int igy = gy_str.toInt(&ok);
+        int igz = gz_str.toInt(&ok);
+
+        if (imu_zero)
+        {
+            // update the new zero values
+            neutral_ax = iax;
+            neutral_ay = iay;
+            neutral_az = iaz;
+            neutral_gx = igx;
+            neutral_gy = igy;
+            neutral_gz = igz;
+            imu_zero = false;
+            zeroed = true;
+        }
+
+        // convert to g's and degs per sec based on zero val
+        // also, remap coordinate axes (right handed) of the car as follows:
+        //      CAR X : - driver left, + driver right = imu -ay
+        //      CAR Y : - down, + up = imu az
+        //      CAR Z : - forward, + backward = imu ax
+        imu_state.ax = (iay - neutral_ay) * GS_PER_STEP * -1;
+        imu_state.ay = (iaz - neutral_az) * GS_PER_STEP;
+        imu_state.az = (iax - neutral_ax) * GS_PER_STEP;
+        imu_state.gx = (igx - neutral_gx) * DPS_PER_STEP * -1;
+        imu_state.gy = (igz - neutral_gz) * DPS_PER_STEP;
+        imu_state.gz = (igy - neutral_gy) * DPS_PER_STEP;
+        imu_state.timestamp = timestamp;
+
+        // shift the buffer down
+        imu_buffer = imu_buffer.mid(pos + imumsg.matchedLength());
+
+        // update anybody listening
+        imu_state.acquired = LatencyClock::Now();
+        emit ImuStateChanged(imu_state);
+    }
+
+    if (zeroed)
+    {
+        emit ImuZeroed();
+    }
+}
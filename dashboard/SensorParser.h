@@ -0,0 +1,88 @@
+#ifndef SENSORPARSER_H
+#define SENSORPARSER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QRegExp>
+#include <QtEndian>
+
+#include "ucvtypes.h"
+#include "LatencyMonitor.h"
+
+// default imu calibration
+#define IMU_DEFAULT_AX 512
+#define IMU_DEFAULT_AY 512
+#define IMU_DEFAULT_AZ 512
+#define IMU_DEFAULT_GX 512
+#define IMU_DEFAULT_GY 512
+#define IMU_DEFAULT_GZ 512
+
+// g's and degrees per second per dac step
+// this is based on 1024 values (10-bit DAC)
+// and +/- 3g range and +/- 300 deg/sec range
+#define GS_PER_STEP 0.005859375
+#define DPS_PER_STEP 0.5859375
+
+// size of the realtime data block the ECU sends back
+#define ECU_BLOCK_SIZE 112
+
+// turns the raw bytes read from the sensor uarts into states
+// this knows nothing about where the bytes came from, so the exact
+// chunks read in the car can be fed back in later for testing
+class SensorParser : public QObject
+{
+    Q_OBJECT
+
+public:
+    SensorParser(QObject *parent = 0);
+    ~SensorParser();
+
+    // a new request for data was sent to the ECU, drop any partial block
+    void EcuRequest();
+
+    // feed chunks of bytes as they were read from each uart, the
+    // timestamp (in ms) is stamped on any state parsed from them
+    void FeedEcu(const char *buf, int len, int timestamp);
+    void FeedGps(const char *buf, int len, int timestamp);
+    void FeedImu(const char *buf, int len, int timestamp);
+
+    // the next imu message becomes the new zero point
+    void ZeroImu() { imu_zero = true; }
+
+signals:
+    void EcuStateChanged(ecustate_t state);
+    void GpsStateChanged(gpsstate_t state);
+    void ImuStateChanged(imustate_t state);
+    void GpsLockChanged(bool locked);
+    void ImuZeroed();
+
+private:
+    // ecu
+    ecustate_t ecu_state;
+    char ecu_block[ECU_BLOCK_SIZE];
+    int ecu_bytes;
+
+    // gps
+    gpsstate_t gps_state;
+    QByteArray gps_buffer;
+    int gps_lock_state;
+    QRegExp dollar;
+    QRegExp ggare;
+    QRegExp vtgre;
+
+    // imu
+    imustate_t imu_state;
+    QByteArray imu_buffer;
+    QRegExp imumsg;
+    bool imu_zero;
+    int neutral_ax;
+    int neutral_ay;
+    int neutral_az;
+    int neutral_gx;
+    int neutral_gy;
+    int neutral_gz;
+
+    void ParseEcuBlock(int timestamp);
+};
+
+#endif // SENSORPARSER_H
@@ -0,0 +1,140 @@
+#include "StatusChannel.h"
+
+#include <QPainter>
+#include <QCoreApplication>
+#include <QPointer>
+
+static const char *source_names[STATUS_SOURCES] = { "ECU", "GPS", "IMU", "XBee", "Driver" };
+
+StatusChannel *StatusChannel::instance()
+{
+    // owned by the application like RunClock
+    static QPointer<StatusChannel> channel;
+    if (channel.isNull()) channel = new StatusChannel();
+    return channel;
+}
+
+StatusChannel::StatusChannel()
+    : QObject(qApp)
+{
+    for (int i = 0; i < STATUS_SOURCES; i++)
+    {
+        sources[i].count = 0;
+        for (int m = 0; m < STATUS_MESSAGES; m++)
+        {
+            statusentry_t &entry = sources[i].messages[m];
+            entry.text = 0;
+            entry.level = STATUS_INFO;
+            entry.suppressed = 0;
+            entry.shown = 0;
+        }
+    }
+}
+
+const char *StatusChannel::SourceName(int source)
+{
+    return source_names[source];
+}
+
+void StatusChannel::Report(int source, int level, const char *text)
+{
+    statussource_t &from = sources[source];
+    from.count++;
+
+    // the entry for this message, or failing that the one that went out
+    // longest ago (unused ones have never gone out)
+    statusentry_t *entry = &from.messages[0];
+    for (int m = 0; m < STATUS_MESSAGES; m++)
+    {
+        if (from.messages[m].text == text)
+        {
+            entry = &from.messages[m];
+            break;
+        }
+        if (from.messages[m].shown < entry->shown) entry = &from.messages[m];
+    }
+    if (entry->text != text)
+    {
+        entry->text = text;
+        entry->level = level;
+        entry->suppressed = 0;
+        entry->shown = 0;
+    }
+
+    // the same message again too soon is only counted, anything new (or
+    // more serious) goes straight out
+    qint64 now = LatencyClock::Now();
+    if (entry->shown != 0 && level <= entry->level &&
+        now - entry->shown < (qint64)STATUS_REPEAT_MS * 1000)
+    {
+        entry->suppressed++;
+        return;
+    }
+
+    QString message = QString("%1: %2").arg(source_names[source]).arg(text);
+    if (entry->suppressed > 0)
+    {
+        message += QString(" (%1 more)").arg(entry->suppressed);
+    }
+
+    entry->level = level;
+    entry->suppressed = 0;
+    entry->shown = now;
+
+    emit StatusPosted(source, level, message);
+}
+
+StatusBanner::StatusBanner(QWidget *parent)
+    : QWidget(parent)
+{
+    message_level = STATUS_INFO;
+
+    setFont(QFont("Fixed", 12, QFont::Bold));
+    resize(width(), fontMetrics().height() + 12);
+
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    timer->setInterval(STATUS_BANNER_MS);
+    connect(timer, SIGNAL(timeout()), this, SLOT(hide()));
+
+    hide();
+}
+
+void StatusBanner::Post(int, int level, QString text)
+{
+    message = text;
+    message_level = level;
+
+    // stays up until things have been quiet for a while
+    timer->start();
+    raise();
+    show();
+    update();
+}
+
+void StatusBanner::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    QColor background;
+    switch (message_level)
+    {
+    case STATUS_ERROR:
+        background = QColor(170, 0, 0, 220);
+        break;
+    case STATUS_WARNING:
+        background = QColor(200, 130, 0, 220);
+        break;
+    default:
+        background = QColor(0, 90, 0, 220);
+        break;
+    }
+    painter.fillRect(rect(), background);
+    painter.setPen(Qt::white);
+    painter.drawText(rect().adjusted(10, 0, -10, 0), Qt::AlignVCenter | Qt::AlignLeft, message);
+}
+
+void StatusBanner::mousePressEvent(QMouseEvent *)
+{
+    timer->stop();
+    hide();
+}
@@ -0,0 +1,106 @@
+#ifndef STATUSCHANNEL_H
+#define STATUSCHANNEL_H
+
+#include <QObject>
+#include <QWidget>
+#include <QTimer>
+#include <QString>
+
+#include "LatencyMonitor.h"
+
+// how often the same message from a source is let through (in ms),
+// repeats in between are only counted
+#define STATUS_REPEAT_MS 2000
+
+// how many different messages from one source are rate limited apart,
+// past that the one that went out longest ago makes room
+#define STATUS_MESSAGES 8
+
+// how long the banner stays up after the last message (in ms)
+#define STATUS_BANNER_MS 5000
+
+// where a message came from, each source is rate limited on its own
+typedef enum
+{
+    STATUS_ECU = 0,
+    STATUS_GPS,
+    STATUS_IMU,
+    STATUS_XBEE,
+    STATUS_DRVR,
+    STATUS_SOURCES
+} status_source_t;
+
+typedef enum
+{
+    STATUS_INFO = 0,
+    STATUS_WARNING,
+    STATUS_ERROR
+} status_level_t;
+
+// one message from a source, with how often it's been held back
+typedef struct
+{
+    const char *text; // 0 for an unused entry
+    int level;
+    int suppressed; // repeats held back since the last one shown
+    qint64 shown;   // when the last one went out (in us on LatencyClock), 0 for never
+} statusentry_t;
+
+// per source counts and the messages it's been sending
+typedef struct
+{
+    int count; // reports since startup
+    statusentry_t messages[STATUS_MESSAGES];
+} statussource_t;
+
+// errors and events from the data path, reported without blocking
+// acquisition (no modal boxes in the middle of a poll) and passed on to
+// whoever is showing them at most once per STATUS_REPEAT_MS per message,
+// so two messages alternating from one source don't let each other through
+// messages are string literals so reporting never allocates, only the
+// ones that get through are turned into a QString
+class StatusChannel : public QObject
+{
+    Q_OBJECT
+
+public:
+    static StatusChannel *instance();
+
+    void Report(int source, int level, const char *text);
+
+    int Count(int source) const { return sources[source].count; }
+
+    static const char *SourceName(int source);
+
+signals:
+    void StatusPosted(int source, int level, QString text);
+
+private:
+    StatusChannel();
+
+    statussource_t sources[STATUS_SOURCES];
+};
+
+// non-modal strip across the top of the dashboard with the latest
+// message, goes away by itself (or when tapped)
+class StatusBanner : public QWidget
+{
+    Q_OBJECT
+
+public:
+    StatusBanner(QWidget *parent = 0);
+
+public slots:
+    void Post(int source, int level, QString text);
+
+protected:
+    virtual void paintEvent(QPaintEvent *event);
+    virtual void mousePressEvent(QMouseEvent *event);
+
+private:
+    QTimer *timer;
+    QString message;
+    int message_level;
+};
+
+#endif // STATUSCHANNEL_H
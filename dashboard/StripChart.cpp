@@ -0,0 +1,219 @@
+#include "StripChart.h"
+
+StripChart::StripChart(QWidget *parent)
+    : QWidget(parent)
+{
+    channel_count = 0;
+    column_ms = 1000;
+    column_end = 0;
+
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+
+    clock.start();
+    timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(Tick()));
+}
+
+int StripChart::AddChannel(QString name, double min, double max, QColor color)
+{
+    if (channel_count >= STRIP_MAX_CHANNELS) return -1;
+
+    // the ring is the only allocation a channel ever makes
+    stripchannel_t &channel = channels[channel_count];
+    channel.name = name;
+    channel.min = min;
+    channel.max = (max > min) ? max : min + 1.0;
+    channel.color = color;
+    channel.ring.resize(STRIP_RING_SIZE);
+    channel.head = 0;
+    channel.count = 0;
+    channel.column_has = false;
+    channel.last = min;
+    channel.last_y = -1;
+
+    return channel_count++;
+}
+
+void StripChart::AddSample(int channel, double value)
+{
+    if (channel < 0 || channel >= channel_count) return;
+    stripchannel_t &ch = channels[channel];
+
+    stripsample_t &sample = ch.ring[ch.head];
+    sample.t = (int)clock.elapsed();
+    sample.value = (float)value;
+    ch.head = (ch.head + 1) & (STRIP_RING_SIZE - 1);
+    if (ch.count < STRIP_RING_SIZE) ch.count++;
+
+    // fold it into the column being built
+    if (!ch.column_has)
+    {
+        ch.column_min = ch.column_max = (float)value;
+        ch.column_has = true;
+    }
+    else
+    {
+        if (value < ch.column_min) ch.column_min = (float)value;
+        if (value > ch.column_max) ch.column_max = (float)value;
+    }
+    ch.last = (float)value;
+}
+
+int StripChart::ValueToY(const stripchannel_t &channel, double value)
+{
+    double f = (value - channel.min) / (channel.max - channel.min);
+    if (f < 0.0) f = 0.0;
+    if (f > 1.0) f = 1.0;
+    return (height() - 2) - (int)(f * (height() - 3));
+}
+
+void StripChart::DrawColumn(QPainter *painter, int x, stripchannel_t &channel, bool has, float lo, float hi, float end)
+{
+    if (!has)
+    {
+        // no new samples, carry the last value on if there ever was one
+        if (channel.last_y < 0) return;
+        painter->setPen(channel.color);
+        painter->drawPoint(x, channel.last_y);
+        return;
+    }
+
+    // span the column's range and join it up with the previous column
+    int y_lo = ValueToY(channel, lo);
+    int y_hi = ValueToY(channel, hi);
+    int top = qMin(y_hi, y_lo);
+    int bottom = qMax(y_hi, y_lo);
+    if (channel.last_y >= 0)
+    {
+        top = qMin(top, channel.last_y);
+        bottom = qMax(bottom, channel.last_y);
+    }
+    painter->setPen(channel.color);
+    painter->drawLine(x, top, x, bottom);
+    channel.last_y = ValueToY(channel, end);
+}
+
+void StripChart::CloseColumn(QPainter *painter, int x)
+{
+    painter->setPen(palette().color(QPalette::Base));
+    painter->drawLine(x, 0, x, height() - 1);
+
+    for (int c = 0; c < channel_count; c++)
+    {
+        stripchannel_t &ch = channels[c];
+        DrawColumn(painter, x, ch, ch.column_has, ch.column_min, ch.column_max, ch.last);
+        ch.column_has = false;
+    }
+}
+
+void StripChart::Tick()
+{
+    int now = (int)clock.elapsed();
+    int columns = 0;
+    while (now >= column_end)
+    {
+        columns++;
+        column_end += column_ms;
+    }
+    if (columns == 0) return;
+
+    // fell behind by more than the whole chart, just start over
+    if (columns >= canvas.width())
+    {
+        Redraw();
+        update();
+        return;
+    }
+
+    // move what's there over, then draw only the new columns on the right
+    // (every column but the last had no samples, the event loop was busy)
+    canvas.scroll(-columns, 0, canvas.rect());
+    QPainter painter(&canvas);
+    for (int i = columns; i > 0; i--)
+    {
+        CloseColumn(&painter, canvas.width() - i);
+    }
+    painter.end();
+
+    update();
+}
+
+void StripChart::Redraw()
+{
+    // rebuild the whole image from the rings, only after a resize
+    canvas.fill(palette().color(QPalette::Base));
+    QPainter painter(&canvas);
+
+    int w = canvas.width();
+    int now = (int)clock.elapsed();
+    int right_end = now - (now % column_ms) + column_ms; // end of the rightmost column
+    column_end = right_end;
+
+    for (int c = 0; c < channel_count; c++)
+    {
+        stripchannel_t &ch = channels[c];
+        ch.last_y = -1;
+
+        int column = -1;
+        float lo = 0, hi = 0, end = 0;
+        int start = (ch.head - ch.count) & (STRIP_RING_SIZE - 1);
+        for (int i = 0; i < ch.count; i++)
+        {
+            const stripsample_t &s = ch.ring[(start + i) & (STRIP_RING_SIZE - 1)];
+            int x = w - 1 - (right_end - 1 - s.t) / column_ms;
+            if (x < 0) continue;
+
+            if (x != column)
+            {
+                // finished a column, draw it
+                if (column >= 0) DrawColumn(&painter, column, ch, true, lo, hi, end);
+                column = x;
+                lo = hi = s.value;
+            }
+            else
+            {
+                if (s.value < lo) lo = s.value;
+                if (s.value > hi) hi = s.value;
+            }
+            end = s.value;
+        }
+
+        // the rightmost column is still being built, the ticks finish it
+        ch.column_has = (column == w - 1);
+        if (ch.column_has)
+        {
+            ch.column_min = lo;
+            ch.column_max = hi;
+        }
+        else if (column >= 0)
+        {
+            DrawColumn(&painter, column, ch, true, lo, hi, end);
+        }
+    }
+}
+
+void StripChart::resizeEvent(QResizeEvent *event)
+{
+    canvas = QPixmap(qMax(width(), 1), qMax(height(), 1));
+    column_ms = qMax(STRIP_SECONDS * 1000 / qMax(width(), 1), 1);
+    Redraw();
+
+    timer->start(column_ms);
+    QWidget::resizeEvent(event);
+}
+
+void StripChart::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.drawPixmap(event->rect(), canvas, event->rect());
+
+    // channel names in their trace colors
+    int x = 4;
+    for (int c = 0; c < channel_count; c++)
+    {
+        painter.setPen(channels[c].color);
+        painter.drawText(x, fontMetrics().ascent() + 2, channels[c].name);
+        x += fontMetrics().width(channels[c].name) + 10;
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef STRIPCHART_H
+#define STRIPCHART_H
+
+#include <QWidget>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QPixmap>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QString>
+#include <QColor>
+
+// how much history the chart shows (in seconds)
+#define STRIP_SECONDS 60
+
+// samples kept per channel, enough for STRIP_SECONDS of the fastest sensor
+#define STRIP_RING_SIZE 8192
+
+// most channels a single chart can show
+#define STRIP_MAX_CHANNELS 4
+
+typedef struct stripsample_struct {
+    int t; // in ms on the chart's clock
+    float value;
+} stripsample_t;
+
+// scrolling chart of the last STRIP_SECONDS of a few channels
+// every column tick the existing image is blitted one column over and
+// only the new column is drawn, so a frame costs the same however much
+// history is on screen; the history itself lives in a fixed ring per
+// channel and is only walked again when the chart is resized
+class StripChart : public QWidget
+{
+    Q_OBJECT
+
+public:
+    StripChart(QWidget *parent = 0);
+
+    // set up a channel (before samples arrive), returns its index or -1
+    int AddChannel(QString name, double min, double max, QColor color);
+
+    virtual QSize sizeHint() const { return QSize(400, 100); }
+
+public slots:
+    void AddSample(int channel, double value);
+
+protected:
+    virtual void paintEvent(QPaintEvent *event);
+    virtual void resizeEvent(QResizeEvent *event);
+
+private slots:
+    void Tick();
+
+private:
+    typedef struct stripchannel_struct {
+        QString name;
+        double min;
+        double max;
+        QColor color;
+        QVector<stripsample_t> ring;
+        int head; // next slot to write
+        int count;
+        bool column_has; // any samples in the column being built
+        float column_min;
+        float column_max;
+        float last;
+        int last_y; // where the trace ended in the previous column, -1 if nowhere
+    } stripchannel_t;
+
+    stripchannel_t channels[STRIP_MAX_CHANNELS];
+    int channel_count;
+
+    QPixmap canvas;
+    QTimer *timer;
+    QElapsedTimer clock;
+    int column_ms; // time covered by one pixel column
+    int column_end; // clock time the column being built closes at
+
+    int ValueToY(const stripchannel_t &channel, double value);
+    void DrawColumn(QPainter *painter, int x, stripchannel_t &channel, bool has, float lo, float hi, float end);
+    void CloseColumn(QPainter *painter, int x);
+    void Redraw();
+};
+
+#endif // STRIPCHART_H
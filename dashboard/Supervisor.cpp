@@ -0,0 +1,81 @@
+#include "Supervisor.h"
+
+#include <cstring>
+
+Supervisor::Supervisor(QObject *parent)
+    : QObject(parent)
+{
+    restart_ms = SUPERVISOR_RESTART_MS;
+
+    // the child shares the console
+    child.setProcessChannelMode(QProcess::ForwardedChannels);
+    connect(&child, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(ChildFinished(int, QProcess::ExitStatus)));
+    connect(&child, SIGNAL(error(QProcess::ProcessError)), this, SLOT(ChildError(QProcess::ProcessError)));
+}
+
+bool Supervisor::Wanted(int argc, char *argv[])
+{
+    bool supervise = false;
+#ifdef RUNNING_IN_CAR
+    supervise = true;
+#endif
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--child") == 0) return false;
+        if (strcmp(argv[i], "--supervise") == 0) supervise = true;
+    }
+    return supervise;
+}
+
+void Supervisor::Start()
+{
+    // pass our own arguments along, marked as the child
+    arguments = QCoreApplication::arguments().mid(1);
+    arguments.removeAll("--supervise");
+    arguments.append("--child");
+
+    Launch();
+}
+
+void Supervisor::Launch()
+{
+    uptime.start();
+    child.start(QCoreApplication::applicationFilePath(), arguments);
+}
+
+void Supervisor::ChildFinished(int exit_code, QProcess::ExitStatus status)
+{
+    // closed on purpose, we're done too
+    if (status == QProcess::NormalExit && exit_code == 0)
+    {
+        QCoreApplication::quit();
+        return;
+    }
+
+    Restart();
+}
+
+void Supervisor::ChildError(QProcess::ProcessError error)
+{
+    // a child that never started won't report finishing either
+    if (error == QProcess::FailedToStart)
+    {
+        Restart();
+    }
+}
+
+void Supervisor::Restart()
+{
+    // back off if it keeps dying straight away
+    if (uptime.elapsed() < SUPERVISOR_STABLE_MS)
+    {
+        restart_ms = qMin(restart_ms * 2, SUPERVISOR_MAX_RESTART_MS);
+    }
+    else
+    {
+        restart_ms = SUPERVISOR_RESTART_MS;
+    }
+
+    QTimer::singleShot(restart_ms, this, SLOT(Launch()));
+}
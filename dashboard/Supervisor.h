@@ -0,0 +1,46 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <QObject>
+#include <QCoreApplication>
+#include <QProcess>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QTimer>
+
+// how soon (in ms) a dashboard that died gets started again, doubling up
+// to the max while it keeps dying within SUPERVISOR_STABLE_MS of starting
+#define SUPERVISOR_RESTART_MS 100
+#define SUPERVISOR_MAX_RESTART_MS 5000
+#define SUPERVISOR_STABLE_MS 10000
+
+// keeps the dashboard running as a child process (the same executable with
+// --child), restarting it whenever it crashes or exits with an error so a
+// run picks up again from its checkpoint, a clean exit ends the supervisor
+class Supervisor : public QObject
+{
+    Q_OBJECT
+
+public:
+    Supervisor(QObject *parent = 0);
+
+    // in the car everything runs supervised, elsewhere only with --supervise
+    static bool Wanted(int argc, char *argv[]);
+
+    void Start();
+
+private slots:
+    void Launch();
+    void ChildFinished(int exit_code, QProcess::ExitStatus status);
+    void ChildError(QProcess::ProcessError error);
+
+private:
+    QProcess child;
+    QStringList arguments;
+    QElapsedTimer uptime;
+    int restart_ms;
+
+    void Restart();
+};
+
+#endif // SUPERVISOR_H
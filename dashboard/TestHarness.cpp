@@ -195,13 +195,19 @@ TestHarness::TestHarness(QWidget *parent)
     tmr_stop_button = new QPushButton("Stop Timer");
     log_start_button = new QPushButton("Start Data Logger");
     log_stop_button = new QPushButton("Stop Data Logger");
-
-    tmr_layout->addWidget(tmr_time_display, 0, 0);
-    tmr_layout->addWidget(tmr_start_button, 1, 0);
-    tmr_layout->addWidget(tmr_stop_button, 2, 0);
-    tmr_layout->addWidget(log_start_button, 3, 0);
-    tmr_layout->addWidget(log_stop_button, 4, 0);
-    tmr_layout->setRowStretch(5, 1);
+    replay_speed_label = new QLabel("Replay Speed (0 = max):");
+    replay_speed_edit = new QLineEdit("1.0");
+    replay_button = new QPushButton("Replay Log File...");
+
+    tmr_layout->addWidget(tmr_time_display, 0, 0, 1, 2);
+    tmr_layout->addWidget(tmr_start_button, 1, 0, 1, 2);
+    tmr_layout->addWidget(tmr_stop_button, 2, 0, 1, 2);
+    tmr_layout->addWidget(log_start_button, 3, 0, 1, 2);
+    tmr_layout->addWidget(log_stop_button, 4, 0, 1, 2);
+    tmr_layout->addWidget(replay_speed_label, 5, 0);
+    tmr_layout->addWidget(replay_speed_edit, 5, 1);
+    tmr_layout->addWidget(replay_button, 6, 0, 1, 2);
+    tmr_layout->setRowStretch(7, 1);
 
     // master layout
     ecu_box->setLayout(ecu_layout);
@@ -229,12 +235,29 @@ TestHarness::TestHarness(QWidget *parent)
     connect(imu_update_button, SIGNAL(clicked()), this, SLOT(UpdateImu()));
     connect(lts_update_button, SIGNAL(clicked()), this, SLOT(UpdateLts()));
     connect(wls_update_button, SIGNAL(clicked()), this, SLOT(UpdateWls()));
+    connect(replay_button, SIGNAL(clicked()), this, SLOT(ReplayLog()));
 
     // done initializing ui, set up some internal stuff
-    timer_running = false;
-    time = new QTime();
-    timer = new QTimer(this);
-    connect(timer, SIGNAL(timeout()), this, SLOT(TimerTick()));
+    clock = RunClock::instance();
+    connect(clock, SIGNAL(Tick(int)), this, SIGNAL(TmrTick(int)));
+
+    // replayed logs come out of the harness just like hand entered data
+    replay = new LogReplay(this);
+    connect(replay, SIGNAL(EcuStateChanged(ecustate_t)), this, SIGNAL(EcuStateChanged(ecustate_t)));
+    connect(replay, SIGNAL(GpsStateChanged(gpsstate_t)), this, SIGNAL(GpsStateChanged(gpsstate_t)));
+    connect(replay, SIGNAL(ImuStateChanged(imustate_t)), this, SIGNAL(ImuStateChanged(imustate_t)));
+    connect(replay, SIGNAL(LtsStateChanged(ltsstate_t)), this, SIGNAL(LtsStateChanged(ltsstate_t)));
+    connect(replay, SIGNAL(TmrTick(int)), this, SIGNAL(TmrTick(int)));
+    connect(replay, SIGNAL(ReplayFinished()), this, SLOT(ReplayFinished()));
+
+    // raw uart captures go through the real parser first
+    replay_parser = new SensorParser(this);
+    capture_replay = new CaptureReplay(replay_parser, this);
+    connect(replay_parser, SIGNAL(EcuStateChanged(ecustate_t)), this, SIGNAL(EcuStateChanged(ecustate_t)));
+    connect(replay_parser, SIGNAL(GpsStateChanged(gpsstate_t)), this, SIGNAL(GpsStateChanged(gpsstate_t)));
+    connect(replay_parser, SIGNAL(ImuStateChanged(imustate_t)), this, SIGNAL(ImuStateChanged(imustate_t)));
+    connect(capture_replay, SIGNAL(TmrTick(int)), this, SIGNAL(TmrTick(int)));
+    connect(capture_replay, SIGNAL(ReplayFinished()), this, SLOT(ReplayFinished()));
 
     // debug
     logger = new DataLogger();
@@ -249,6 +272,16 @@ TestHarness::TestHarness(QWidget *parent)
     connect(this, SIGNAL(ImuStateChanged(imustate_t)), logger, SLOT(ImuUpdate(imustate_t)));
     connect(this, SIGNAL(LtsStateChanged(ltsstate_t)), logger, SLOT(LtsUpdate(ltsstate_t)));
     connect(this, SIGNAL(TmrTick(int)), logger, SLOT(TmrUpdate(int)));
+    connect(dashboard, SIGNAL(LapCompleted(int, int)), logger, SLOT(LapUpdate(int, int)));
+
+    // and to the always-on flight recorder
+    recorder = new FlightRecorder(this);
+    recorder->Open(FLIGHT_FILENAME, QDir());
+    connect(this, SIGNAL(EcuStateChanged(ecustate_t)), recorder, SLOT(EcuUpdate(ecustate_t)));
+    connect(this, SIGNAL(GpsStateChanged(gpsstate_t)), recorder, SLOT(GpsUpdate(gpsstate_t)));
+    connect(this, SIGNAL(ImuStateChanged(imustate_t)), recorder, SLOT(ImuUpdate(imustate_t)));
+    connect(this, SIGNAL(LtsStateChanged(ltsstate_t)), recorder, SLOT(LtsUpdate(ltsstate_t)));
+    connect(dashboard, SIGNAL(LapCompleted(int, int)), recorder, SLOT(LapUpdate(int, int)));
 
     // connect up the test harness to the dashboard
     connect(this, SIGNAL(TmrTick(int)), dashboard, SLOT(TmrUpdate(int)));
@@ -256,35 +289,49 @@ TestHarness::TestHarness(QWidget *parent)
     connect(this, SIGNAL(GpsStateChanged(gpsstate_t)), dashboard, SLOT(GpsUpdate(gpsstate_t)));
     connect(this, SIGNAL(ImuStateChanged(imustate_t)), dashboard, SLOT(ImuUpdate(imustate_t)));
     connect(this, SIGNAL(LtsStateChanged(ltsstate_t)), dashboard, SLOT(LtsUpdate(ltsstate_t)));
+
+    // count laps off the gps fixes, same as in the car
+    lap_detector = new LapDetector(this);
+    lap_detector->Load(LAPGATE_FILENAME);
+    connect(this, SIGNAL(GpsStateChanged(gpsstate_t)), lap_detector, SLOT(GpsUpdate(gpsstate_t)));
+    connect(lap_detector, SIGNAL(LapCrossed(int)), dashboard, SLOT(LapCrossed(int)));
+    connect(dashboard, SIGNAL(SetStartFinish()), lap_detector, SLOT(SetGateHere()));
+    connect(dashboard, SIGNAL(StartRun(qint64)), lap_detector, SLOT(Reset()));
+
+    // and let an armed run start itself
+    trigger = new RunTrigger(this);
+    connect(this, SIGNAL(EcuStateChanged(ecustate_t)), trigger, SLOT(EcuUpdate(ecustate_t)));
+    connect(this, SIGNAL(GpsStateChanged(gpsstate_t)), trigger, SLOT(GpsUpdate(gpsstate_t)));
+    connect(dashboard, SIGNAL(ArmRun(bool)), trigger, SLOT(SetArmed(bool)));
+    connect(trigger, SIGNAL(Triggered(qint64)), this, SLOT(RunTriggered(qint64)));
+    connect(trigger, SIGNAL(Triggered(qint64)), dashboard, SLOT(RunTriggered()));
 }
 
 TestHarness::~TestHarness()
 {
-    delete time;
+    // nothing yet
 }
 
 void TestHarness::TmrStart()
 {
-    if (!timer_running)
+    if (!clock->IsRunning())
     {
-        time->start();
-        timer->start(1000);
-        timer_running = true;
+        clock->Start();
     }
 }
 
-void TestHarness::TmrStop()
+void TestHarness::RunTriggered(qint64 origin_us)
 {
-    if (timer_running)
+    if (!clock->IsRunning())
     {
-        timer->stop();
-        timer_running = false;
+        clock->StartAt(origin_us);
+        lap_detector->Reset();
     }
 }
 
-void TestHarness::TimerTick()
+void TestHarness::TmrStop()
 {
-    emit TmrTick(time->elapsed());
+    clock->Stop();
 }
 
 void TestHarness::WlsDataSend(QByteArray data)
@@ -331,7 +378,8 @@ void TestHarness::UpdateEcu()
     state.batt = ecu_batt_edit->text().toDouble();
     state.maf = ecu_maf_edit->text().toDouble();
     state.tach_count = ecu_tc_edit->text().toInt();
-    state.timestamp = (timer_running) ? time->elapsed() : 0;
+    state.timestamp = clock->Elapsed();
+    state.acquired = LatencyClock::Now();
 
     emit EcuStateChanged(state);
 
@@ -356,7 +404,8 @@ void TestHarness::UpdateGps()
     state.alt = gps_alt_edit->text().toDouble();
     state.speed = gps_speed_edit->text().toDouble();
     state.heading = gps_heading_edit->text().toDouble();
-    state.timestamp = (timer_running) ? time->elapsed() : 0;
+    state.timestamp = clock->Elapsed();
+    state.acquired = LatencyClock::Now();
 
     emit GpsStateChanged(state);
 
@@ -375,7 +424,8 @@ void TestHarness::UpdateImu()
     state.gx = imu_gx_edit->text().toDouble();
     state.gy = imu_gy_edit->text().toDouble();
     state.gz = imu_gz_edit->text().toDouble();
-    state.timestamp = (timer_running) ? time->elapsed() : 0;
+    state.timestamp = clock->Elapsed();
+    state.acquired = LatencyClock::Now();
 
     emit ImuStateChanged(state);
 
@@ -393,7 +443,7 @@ void TestHarness::UpdateLts()
     state.left_turn = lts_left_edit->isChecked();
     state.right_turn = lts_right_edit->isChecked();
     state.hazards = lts_hazards_edit->isChecked();
-    state.timestamp = (timer_running) ? time->elapsed() : 0;
+    state.timestamp = clock->Elapsed();
 
     emit LtsStateChanged(state);
 
@@ -410,3 +460,49 @@ void TestHarness::UpdateWls()
     msg_box.setText("Wireless data arrived signal has been dispatched.");
     msg_box.exec();
 }
+
+void TestHarness::ReplayLog()
+{
+    if (replay->IsRunning() || capture_replay->IsRunning())
+    {
+        replay->Stop();
+        capture_replay->Stop();
+        ReplayFinished();
+        return;
+    }
+
+    QString filepath = QFileDialog::getOpenFileName(this, "Replay Log File", QString(),
+                                                    "Log Files (*.ucv);;Raw UART Captures (*.ucr)");
+    if (filepath.isEmpty()) return;
+
+    bool raw = filepath.endsWith(".ucr", Qt::CaseInsensitive);
+    bool opened = (raw) ? capture_replay->Open(filepath) : replay->Open(filepath);
+    if (!opened)
+    {
+        QMessageBox msg_box;
+        msg_box.setText(QString("Could not open %1.").arg(filepath));
+        msg_box.exec();
+        return;
+    }
+
+    // don't mix the replayed run with the harness timer
+    TmrStop();
+
+    double speed = replay_speed_edit->text().toDouble();
+    if (raw)
+    {
+        capture_replay->SetSpeed(speed);
+        capture_replay->Start();
+    }
+    else
+    {
+        replay->SetSpeed(speed);
+        replay->Start();
+    }
+    replay_button->setText("Stop Replay");
+}
+
+void TestHarness::ReplayFinished()
+{
+    replay_button->setText("Replay Log File...");
+}
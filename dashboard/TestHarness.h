@@ -14,9 +14,17 @@
 #include <QTimer>
 #include <QMessageBox>
 #include <QByteArray>
+#include <QFileDialog>
 
 #include "DataLogger.h"
+#include "LogReplay.h"
+#include "CaptureReplay.h"
+#include "SensorParser.h"
 #include "Dashboard.h"
+#include "LapDetector.h"
+#include "RunClock.h"
+#include "RunTrigger.h"
+#include "FlightRecorder.h"
 #include "ucvtypes.h"
 
 class TestHarness : public QWidget
@@ -37,14 +45,16 @@ public slots:
     void LtsHazards(bool hazards);
     void TmrStart();
     void TmrStop();
+    void RunTriggered(qint64 origin_us);
 
     // gui and internal use slots
-    void TimerTick();
     void UpdateEcu();
     void UpdateGps();
     void UpdateImu();
     void UpdateLts();
     void UpdateWls();
+    void ReplayLog();
+    void ReplayFinished();
 
 signals:
     // hardware interface emulation
@@ -67,7 +77,7 @@ private:
            *imu_az_label, *imu_gx_label, *imu_gy_label,
            *imu_gz_label, *lts_head_label, *lts_brake_label,
            *lts_left_label, *lts_right_label, *lts_hazards_label,
-           *wls_rx_label, *wls_tx_label;
+           *wls_rx_label, *wls_tx_label, *replay_speed_label;
     QLineEdit *ecu_rpm_edit, *ecu_spark_edit, *ecu_map_edit,
               *ecu_mat_edit, *ecu_clt_edit, *ecu_tps_edit,
               *ecu_batt_edit, *ecu_maf_edit, *ecu_tc_edit,
@@ -76,22 +86,28 @@ private:
               *gps_longmin_edit, *gps_latdir_edit, *gps_longdir_edit,
               *gps_alt_edit, *gps_speed_edit, *gps_heading_edit,
               *imu_ax_edit, *imu_ay_edit, *imu_az_edit,
-              *imu_gx_edit, *imu_gy_edit, *imu_gz_edit;
+              *imu_gx_edit, *imu_gy_edit, *imu_gz_edit,
+              *replay_speed_edit;
     QCheckBox *ecu_cranking_edit, *lts_head_edit, *lts_brake_edit,
               *lts_left_edit, *lts_right_edit, *lts_hazards_edit;
     QTextEdit *wls_rx_edit, *wls_tx_edit;
     QLCDNumber *tmr_time_display;
     QPushButton *ecu_update_button, *gps_update_button, *imu_update_button,
                 *lts_update_button, *wls_update_button, *tmr_start_button,
-                *tmr_stop_button, *log_start_button, *log_stop_button;
+                *tmr_stop_button, *log_start_button, *log_stop_button,
+                *replay_button;
 
-    bool timer_running;
-    QTime *time;
-    QTimer *timer;
+    RunClock *clock;
+    LogReplay *replay;
+    SensorParser *replay_parser;
+    CaptureReplay *capture_replay;
 
     // debug
     DataLogger *logger;
     Dashboard *dashboard;
+    LapDetector *lap_detector;
+    RunTrigger *trigger;
+    FlightRecorder *recorder;
 };
 
 #endif // TESTHARNESS_H
@@ -0,0 +1,201 @@
+#include "TrackMap.h"
+
+TrackMap::TrackMap(QWidget *parent)
+    : QWidget(parent)
+{
+    layer_valid = false;
+    scale = 1.0;
+    has_car = false;
+
+    // a 40 minute run at a few fixes a second fits without reallocating
+    trail.reserve(16384);
+
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
+}
+
+void TrackMap::SetReference(const ReferenceLap &lap)
+{
+    reference.resize(0);
+    if (!lap.IsEmpty() && !projection.IsSet())
+    {
+        projection.SetOrigin(lap.Point(0).lat, lap.Point(0).lon);
+    }
+
+    for (int i = 0; i < lap.Size(); i++)
+    {
+        QPointF p = projection.Project(lap.Point(i).lat, lap.Point(i).lon);
+        reference.append(p);
+        Include(p);
+    }
+
+    layer_valid = false;
+    update();
+}
+
+void TrackMap::ClearTrail()
+{
+    trail.resize(0);
+    layer_valid = false;
+    update();
+}
+
+void TrackMap::GpsUpdate(gpsstate_t state)
+{
+    if (!LocalProjection::HasFix(state.pos)) return;
+
+    // the first fix picks the origin if there's no reference lap yet
+    if (!projection.IsSet())
+    {
+        projection.SetOrigin(LocalProjection::Latitude(state.pos),
+                             LocalProjection::Longitude(state.pos));
+    }
+
+    QPointF p = projection.Project(state.pos);
+    QRect dirty = has_car ? CarRect() : QRect();
+    car = p;
+    has_car = true;
+    dirty |= CarRect();
+
+    // leaving the mapped area means the whole layer has to be refitted
+    if (!bounds.contains(p))
+    {
+        Include(p);
+        layer_valid = false;
+    }
+
+    if (trail.isEmpty())
+    {
+        trail.append(p);
+    }
+    else
+    {
+        QPointF last = trail.last();
+        QPointF step = p - last;
+        if (step.x() * step.x() + step.y() * step.y() >= TRACKMAP_MIN_STEP_M * TRACKMAP_MIN_STEP_M)
+        {
+            trail.append(p);
+
+            // draw just the new segment onto the cached layer
+            if (layer_valid)
+            {
+                QPointF a = ToPixel(last);
+                QPointF b = ToPixel(p);
+                QPainter painter(&layer);
+                painter.setRenderHint(QPainter::Antialiasing);
+                painter.setPen(QPen(Qt::darkBlue, 2));
+                painter.drawLine(a, b);
+                dirty |= QRectF(a, b).normalized().toAlignedRect().adjusted(-2, -2, 2, 2);
+            }
+        }
+    }
+
+    if (layer_valid)
+    {
+        update(dirty);
+    }
+    else
+    {
+        update();
+    }
+}
+
+void TrackMap::Include(const QPointF &p)
+{
+    if (bounds.isNull())
+    {
+        double half = TRACKMAP_START_SPAN_M / 2;
+        bounds = QRectF(p.x() - half, p.y() - half, TRACKMAP_START_SPAN_M, TRACKMAP_START_SPAN_M);
+        return;
+    }
+    if (bounds.contains(p)) return;
+
+    // grow by a quarter on every side so the next few fixes still fit
+    bounds = bounds.united(QRectF(p, QSizeF(0.001, 0.001)));
+    double dx = bounds.width() / 4;
+    double dy = bounds.height() / 4;
+    bounds.adjust(-dx, -dy, dx, dy);
+}
+
+void TrackMap::resizeEvent(QResizeEvent *event)
+{
+    layer_valid = false;
+    QWidget::resizeEvent(event);
+}
+
+QPointF TrackMap::ToPixel(const QPointF &p) const
+{
+    // north is up, so y flips
+    QPointF mid = bounds.center();
+    return QPointF(center.x() + (p.x() - mid.x()) * scale,
+                   center.y() - (p.y() - mid.y()) * scale);
+}
+
+QRect TrackMap::CarRect() const
+{
+    QPointF c = ToPixel(car);
+    int r = TRACKMAP_CAR_RADIUS + 1;
+    return QRect((int)c.x() - r, (int)c.y() - r, 2 * r + 1, 2 * r + 1);
+}
+
+void TrackMap::Rebuild()
+{
+    if (layer.size() != size())
+    {
+        layer = QPixmap(size());
+    }
+    layer.fill(Qt::white);
+
+    // same scale on both axes, fit the longer side
+    center = QPointF(width() / 2.0, height() / 2.0);
+    if (bounds.isNull())
+    {
+        scale = 1.0;
+    }
+    else
+    {
+        scale = qMin((width() - 8) / bounds.width(), (height() - 8) / bounds.height());
+    }
+
+    QPainter painter(&layer);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    QVector<QPointF> pixels;
+    pixels.reserve(qMax(reference.size(), trail.size()));
+
+    for (int i = 0; i < reference.size(); i++)
+    {
+        pixels.append(ToPixel(reference[i]));
+    }
+    painter.setPen(QPen(QColor(200, 200, 200), 5, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+    painter.drawPolyline(pixels.constData(), pixels.size());
+
+    pixels.resize(0);
+    for (int i = 0; i < trail.size(); i++)
+    {
+        pixels.append(ToPixel(trail[i]));
+    }
+    painter.setPen(QPen(Qt::darkBlue, 2));
+    painter.drawPolyline(pixels.constData(), pixels.size());
+
+    layer_valid = true;
+}
+
+void TrackMap::paintEvent(QPaintEvent *event)
+{
+    if (!layer_valid)
+    {
+        Rebuild();
+    }
+
+    QPainter painter(this);
+    painter.drawPixmap(event->rect(), layer, event->rect());
+
+    if (has_car)
+    {
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(Qt::red);
+        painter.drawEllipse(ToPixel(car), TRACKMAP_CAR_RADIUS, TRACKMAP_CAR_RADIUS);
+    }
+}
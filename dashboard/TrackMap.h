@@ -0,0 +1,71 @@
+#ifndef TRACKMAP_H
+#define TRACKMAP_H
+
+#include <QWidget>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QPixmap>
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+
+#include "ucvtypes.h"
+#include "LocalProjection.h"
+#include "ReferenceLap.h"
+
+// fixes closer than this to the last trail point don't extend the trail
+// (in m), so sitting still doesn't pile up points
+#define TRACKMAP_MIN_STEP_M 1.0
+
+// room around the first fix before there's a reference lap to fit (in m)
+#define TRACKMAP_START_SPAN_M 100.0
+
+// radius of the car marker (in pixels)
+#define TRACKMAP_CAR_RADIUS 4
+
+// plan view of the car's trail over a stored reference lap
+// the reference and the trail live in a cached layer and each fix only
+// draws its new trail segment onto it, the layer is only redrawn from the
+// stored points when the widget resizes or the car leaves the mapped area
+// (which grows with a margin so that happens a handful of times at most)
+class TrackMap : public QWidget
+{
+    Q_OBJECT
+
+public:
+    TrackMap(QWidget *parent = 0);
+
+    virtual QSize sizeHint() const { return QSize(120, 120); }
+
+    void SetReference(const ReferenceLap &lap);
+
+public slots:
+    void GpsUpdate(gpsstate_t state);
+    void ClearTrail();
+
+protected:
+    virtual void paintEvent(QPaintEvent *event);
+    virtual void resizeEvent(QResizeEvent *event);
+
+private:
+    LocalProjection projection;
+    QVector<QPointF> reference; // in m
+    QVector<QPointF> trail; // in m
+    QRectF bounds; // area of the track shown (in m)
+
+    QPixmap layer;
+    bool layer_valid;
+    double scale; // pixels per m
+    QPointF center; // middle of the widget (in pixels)
+
+    bool has_car;
+    QPointF car; // in m
+
+    void Include(const QPointF &p);
+    void Rebuild();
+    QPointF ToPixel(const QPointF &p) const;
+    QRect CarRect() const;
+};
+
+#endif // TRACKMAP_H
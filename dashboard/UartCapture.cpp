@@ -0,0 +1,97 @@
+#include "UartCapture.h"
+
+#include <cstring>
+
+UartCapture::UartCapture()
+{
+    capfile = NULL;
+    buffer = new char[CAPTURE_BUFFER_SIZE];
+    buffered = 0;
+}
+
+UartCapture::~UartCapture()
+{
+    // don't delete me without flushing my data to disk!
+    Stop();
+
+    delete [] buffer;
+}
+
+bool UartCapture::Start()
+{
+    // can't start it if it's already running
+    if (capfile != NULL) return true;
+
+    // name it just like the log files, but with its own extension
+    QDateTime now = QDateTime::currentDateTime();
+    QString filename = now.toString("yyyy-MM-dd_hh-mm-ss");
+    filename += ".ucr";
+
+    capfile = new QFile(directory.absoluteFilePath(filename));
+    if (!capfile->open(QIODevice::WriteOnly))
+    {
+        delete capfile;
+        capfile = NULL;
+        return false;
+    }
+
+    buffered = 0;
+    return true;
+}
+
+void UartCapture::Stop()
+{
+    if (capfile == NULL) return;
+
+    Flush();
+    capfile->close();
+    delete capfile;
+    capfile = NULL;
+}
+
+void UartCapture::Write(quint8 channel, int timestamp, const char *buf, int len)
+{
+    if (capfile == NULL || len < 0) return;
+
+    // a uart never hands us more than a few hundred bytes at once,
+    // but split anything bigger so the length always fits
+    while (len > 0xFFFF)
+    {
+        Write(channel, timestamp, buf, 0xFFFF);
+        buf += 0xFFFF;
+        len -= 0xFFFF;
+    }
+
+    if (buffered + CAPTURE_HEADER_SIZE + len > CAPTURE_BUFFER_SIZE)
+    {
+        Flush();
+    }
+
+    if (CAPTURE_HEADER_SIZE + len > CAPTURE_BUFFER_SIZE)
+    {
+        // too big to ever fit in the buffer, write it straight out
+        char header[CAPTURE_HEADER_SIZE];
+        header[0] = channel;
+        qToBigEndian<qint32>(timestamp, (uchar *)header + 1);
+        qToBigEndian<quint16>(len, (uchar *)header + 5);
+        capfile->write(header, CAPTURE_HEADER_SIZE);
+        capfile->write(buf, len);
+        return;
+    }
+
+    uchar *out = (uchar *)buffer + buffered;
+    out[0] = channel;
+    qToBigEndian<qint32>(timestamp, out + 1);
+    qToBigEndian<quint16>(len, out + 5);
+    if (len > 0) memcpy(out + CAPTURE_HEADER_SIZE, buf, len);
+    buffered += CAPTURE_HEADER_SIZE + len;
+}
+
+void UartCapture::Flush()
+{
+    if (capfile == NULL || buffered == 0) return;
+
+    capfile->write(buffer, buffered);
+    capfile->flush();
+    buffered = 0;
+}
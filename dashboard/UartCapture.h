@@ -0,0 +1,48 @@
+#ifndef UARTCAPTURE_H
+#define UARTCAPTURE_H
+
+#include <QDir>
+#include <QFile>
+#include <QDateTime>
+#include <QByteArray>
+#include <QtEndian>
+
+// channel identifiers for captured chunks (single byte)
+#define CAPTURE_ECU 0x01
+#define CAPTURE_GPS 0x02
+#define CAPTURE_IMU 0x03
+#define CAPTURE_ECU_REQUEST 0x81 // no payload, a data request was sent
+#define CAPTURE_IMU_ZERO 0x82 // no payload, the imu zero was requested
+
+// each chunk is stored as channel (1 byte), timestamp in ms (4 bytes),
+// payload length (2 bytes) and then the payload, all big-endian
+#define CAPTURE_HEADER_SIZE 7
+
+// bytes held in memory before they're written out to the capture file
+#define CAPTURE_BUFFER_SIZE 65536
+
+// records every chunk of bytes read from the sensor uarts, exactly as
+// it arrived, so a run can be fed back through the SensorParser later
+class UartCapture
+{
+public:
+    UartCapture();
+    ~UartCapture();
+
+    void SetDirectory(QDir dir) { directory = dir; }
+
+    bool Start();
+    void Stop();
+    bool IsRunning() { return capfile != NULL; }
+
+    void Write(quint8 channel, int timestamp, const char *buf, int len);
+    void Flush();
+
+private:
+    QDir directory;
+    QFile *capfile;
+    char *buffer;
+    int buffered;
+};
+
+#endif // UARTCAPTURE_H
@@ -2,6 +2,16 @@
 
 int main(int argc, char *argv[])
 {
+    // a supervisor process just keeps the real dashboard (its child)
+    // running, a crashed dashboard comes back and resumes the run
+    if (Supervisor::Wanted(argc, argv))
+    {
+        QCoreApplication supervisor_app(argc, argv);
+        Supervisor supervisor;
+        supervisor.Start();
+        return supervisor_app.exec();
+    }
+
     QApplication a(argc, argv);
 
 #ifndef RUNNING_IN_CAR
@@ -3,6 +3,8 @@
 
 #include <QApplication>
 
+#include "Supervisor.h"
+
 #ifndef RUNNING_IN_CAR
     #include "TestHarness.h"
 #else
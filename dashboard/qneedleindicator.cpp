@@ -18,8 +18,60 @@
  ***************************************************************************/
 
 #include "qneedleindicator.h"
+#include <QCoreApplication>
+#include <QPointer>
 #include <cmath>
 
+/* Needle response: a critically damped spring with this natural frequency */
+/* (rad/s) gets within 1% of a step change in about 0.17 s.                */
+#define NEEDLE_OMEGA        40.0
+/* Frame period of the shared animation clock (ms)                         */
+#define NEEDLE_FRAME_MS     16
+/* Longest step taken in one frame (s), so a stalled event loop doesn't    */
+/* make the needle jump                                                    */
+#define NEEDLE_MAX_DT       0.1
+/* Needle counts as settled within this fraction of the scale              */
+#define NEEDLE_SETTLE       0.001
+
+QNeedleAnimator::QNeedleAnimator(void) : QObject(qApp) {
+    timer.setInterval(NEEDLE_FRAME_MS);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+QNeedleAnimator *QNeedleAnimator::instance(void) {
+    /* Owned by the application, so its timer is gone before QApplication */
+    /* is; a QPointer so a needle outliving it never gets a dead one     */
+    static QPointer<QNeedleAnimator> animator;
+    if( animator.isNull() ) animator = new QNeedleAnimator();
+    return animator;
+}
+
+void QNeedleAnimator::start(QNeedleIndicator *needle) {
+    if( moving.contains(needle) ) return;
+    moving.append(needle);
+    if( ! timer.isActive() ) {  // first needle to move; start the clock
+        clock.start();
+        timer.start();
+    }
+}
+
+void QNeedleAnimator::stop(QNeedleIndicator *needle) {
+    moving.removeAll(needle);
+    if( moving.isEmpty() ) timer.stop();
+}
+
+void QNeedleAnimator::tick(void) {
+    /* Step by the time that actually passed, not by a frame count, so */
+    /* the needle keeps up even when frames are late                   */
+    qreal dt = clock.restart() / 1000.0;
+    if( dt > NEEDLE_MAX_DT ) dt = NEEDLE_MAX_DT;
+
+    for(int i = moving.size() - 1; i >= 0; i--) {
+        if( moving[i]->animate(dt) ) moving.removeAt(i);
+    }
+    if( moving.isEmpty() ) timer.stop();   // everything settled; go idle
+}
+
 QNeedleIndicator::QNeedleIndicator(QWidget *parent) : QWidget(parent)
 {
     // Set some default values. FIX: shouldn't be hardcoded
@@ -33,6 +85,8 @@ QNeedleIndicator::QNeedleIndicator(QWidget *parent) : QWidget(parent)
     max     = 100;
     min     = 0;
     value   = 0;
+    currValue = 0;
+    velocity  = 0;
     step    = max / (majorTicks-1);
     labelOffset = 115 * 0.6;
     digitFont = QFont("SansSerif", 8);
@@ -40,28 +94,36 @@ QNeedleIndicator::QNeedleIndicator(QWidget *parent) : QWidget(parent)
     label.clear();
     scaleFormat = "%.2f";
     animated = true;
-    timer   = new QTimer(this);
-    timer->setInterval(100);
-    connect(timer, SIGNAL(timeout()), this, SLOT(animate()));
+    dialValid = false;
+    dialCached = true;
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     setMinimumSize(200,200);
 
 }
 
-void QNeedleIndicator::animate() {
-    qreal p,s,f;
-    animFrame++;
-    // Divide value delta on pieces. Pieces length decrease.
-    p = 10.0/((qreal)animFrame);
-    s = 0;
-    for(int i = 1; i <= 10; i++) s+=10.0/static_cast<qreal>(i); // Fix this crap
-    f=p/s;
-    currValue+=(valueDelta*f);
-    if(animFrame >= 10) {
-        timer->stop();
-        currValue = value;  // lock the needle after animation on final position
+QNeedleIndicator::~QNeedleIndicator() {
+    QNeedleAnimator::instance()->stop(this);
+}
+
+bool QNeedleIndicator::animate(qreal dt) {
+    QRect before = needleRect(currValue);
+
+    /* Exact step of a critically damped spring towards value; it */
+    /* follows a moving target without overshoot or lag build-up  */
+    qreal offset = currValue - value;
+    qreal temp   = (velocity + NEEDLE_OMEGA*offset)*dt;
+    qreal decay  = exp(-NEEDLE_OMEGA*dt);
+    velocity  = (velocity - NEEDLE_OMEGA*temp)*decay;
+    currValue = value + (offset + temp)*decay;
+
+    qreal eps = (max-min)*NEEDLE_SETTLE;
+    bool settled = fabs(currValue-value) < eps && fabs(velocity) < eps*NEEDLE_OMEGA;
+    if( settled ) {
+        currValue = value;  // lock the needle on final position
+        velocity  = 0;
     }
-    update();
+    update(before | needleRect(currValue));    // only where the needle swept
+    return settled;
 }
 
 qreal QNeedleIndicator::getValue(void) {
@@ -69,20 +131,57 @@ qreal QNeedleIndicator::getValue(void) {
 }
 
 void QNeedleIndicator::startAnimation(void) {
-    animFrame = 0;
-    valueDelta = value-currValue;   // we need to move needle by valueDelta
-    if( ! timer->isActive())        // fire timer; it will start moving the needle
-        timer->start();             // from currValue to value
+    if( value != currValue )        // shared clock moves the needle from
+        QNeedleAnimator::instance()->start(this);  // currValue to value
+}
+
+void QNeedleIndicator::invalidateDial(void) {
+    dialValid = false;
+    update();
 }
 
 void QNeedleIndicator::resizeEvent(QResizeEvent *event) {
+    dialValid = false;
     QWidget::resizeEvent(event);
 }
 
 void QNeedleIndicator::paintEvent (QPaintEvent  *event) {
-    drawBackground();
-    drawNeedle();
+    QElapsedTimer paintTimer;
+    paintTimer.start();
+
+    if( !dialCached ) {             // uncached: the whole dial, every paint
+        QPainter painter(this);
+        painter.setClipRect(event->rect());
+        painter.save();
+        drawBackground(&painter);
+        painter.restore();
+        drawNeedle(&painter);
+        painter.end();
+        QWidget::paintEvent(event);
+
+        emit painted((int)(paintTimer.nsecsElapsed() / 1000));
+        return;
+    }
+
+    /* The dial only changes with size, range, fonts or label, so it is  */
+    /* rendered once into a pixmap and each frame just blits it back.    */
+    if( !dialValid || dial.size() != size() ) {
+        dial = QPixmap(size());
+        dial.fill(Qt::transparent);
+        QPainter dialPainter(&dial);
+        drawBackground(&dialPainter);
+        dialValid = true;
+    }
+
+    /* Only the exposed part of the dial is blitted back; after a needle */
+    /* move that is just the area the needle swept over                  */
+    QPainter painter(this);
+    painter.drawPixmap(event->rect(), dial, event->rect());
+    drawNeedle(&painter);
+    painter.end();
     QWidget::paintEvent(event);
+
+    emit painted((int)(paintTimer.nsecsElapsed() / 1000));
 }
 
 void QNeedleIndicator::setMajorTicks(int t) {
@@ -90,32 +189,49 @@ void QNeedleIndicator::setMajorTicks(int t) {
     step = max/(majorTicks-1);
     rot_deg = stop_angle/(majorTicks-1);
     rot_rad = (rot_deg/360.0)*2*M_PI;
-    update();
+    invalidateDial();
 }
 
 void QNeedleIndicator::setMinorTicks(int t) {
     minorTicks = static_cast<qreal>(t);
-    update();
+    invalidateDial();
 }
 
 void QNeedleIndicator::setDigitFont(QFont f) {
     digitFont = f;
-    update();
+    invalidateDial();
 }
 
 void QNeedleIndicator::setLabelFont(QFont f) {
     labelFont = f;
-    update();
+    invalidateDial();
 }
 
 void QNeedleIndicator::setAnimated(bool anim) {
     animated = anim;
+    if( ! animated ) {              // jump straight to the value
+        QNeedleAnimator::instance()->stop(this);
+        currValue = value;
+        velocity  = 0;
+        update();
+    }
 }
 
 bool QNeedleIndicator::isAnimated(void) {
     return animated;
 }
 
+void QNeedleIndicator::setDialCached(bool cached) {
+    dialCached = cached;
+    dial = QPixmap();               // don't hold on to a stale pixmap
+    dialValid = false;
+    update();
+}
+
+bool QNeedleIndicator::isDialCached(void) {
+    return dialCached;
+}
+
 void QNeedleIndicator::setValue(qreal v) {
     if(v > max) v = max;    // coerce
     if(v < min) v = min;
@@ -123,25 +239,27 @@ void QNeedleIndicator::setValue(qreal v) {
         value = v;
         startAnimation();
     } else {                // instant update
+        QRect before = needleRect(currValue);
         currValue = value = v;
-        update();
+        update(before | needleRect(currValue));
     }
 }
 
 void QNeedleIndicator::setLabel(QString l) {
     label = l;
-    update();
+    invalidateDial();
 }
 
 void QNeedleIndicator::setDigitFormat(QString format) {
     scaleFormat = format.toLatin1();
+    invalidateDial();
 }
 
 void QNeedleIndicator::setRange(qreal mi, qreal ma) {
     min  = mi;
     max  = ma;
     step = (max-min)/(majorTicks-1);
-    update();
+    invalidateDial();
 }
 
 void QNeedleIndicator::setMinValue(qreal mi) {
@@ -158,7 +276,7 @@ void QNeedleIndicator::setGapAngle(qreal gap) {
     stop_angle  = 360 - gap_angle;
     rot_deg = stop_angle/(majorTicks-1);
     rot_rad = (rot_deg/360.0)*2*M_PI;
-    update();
+    invalidateDial();
 }
 
 void QNeedleIndicator::setLabelOffset(qreal offset) {
@@ -166,7 +284,7 @@ void QNeedleIndicator::setLabelOffset(qreal offset) {
     if( offset < 0 ) offset = 0;
     if( offset > 1 ) offset = 1;
     labelOffset = 115*offset;
-    update();
+    invalidateDial();
 }
 
 qreal QNeedleIndicator::value2angle(qreal val) {
@@ -174,7 +292,7 @@ qreal QNeedleIndicator::value2angle(qreal val) {
     return start_angle + (val/max)*stop_angle;
 }
 
-void QNeedleIndicator::drawNeedle(void) {
+void QNeedleIndicator::drawNeedle(QPainter *painter) {
     int side = qMin(width(), height());
 
     static const QPoint needle[5] = {
@@ -184,107 +302,122 @@ void QNeedleIndicator::drawNeedle(void) {
             QPoint(-30,5),
             QPoint(-30,-5)
     };
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.translate(width() / 2, height() / 2);
-    painter.scale(side / 256.0, side / 256.0);
-    painter.save();
-    painter.rotate(value2angle(currValue));
-    painter.setBrush(Qt::red);
-    painter.drawConvexPolygon(needle, 5);
-    painter.setBrush(Qt::black);
-    painter.drawEllipse(QPoint(0,0), 5,5);
-    painter.restore();
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->translate(width() / 2, height() / 2);
+    painter->scale(side / 256.0, side / 256.0);
+    painter->rotate(value2angle(currValue));
+    painter->setBrush(Qt::red);
+    painter->drawConvexPolygon(needle, 5);
+    painter->setBrush(Qt::black);
+    painter->drawEllipse(QPoint(0,0), 5,5);
+    painter->restore();
 
 }
 
-void QNeedleIndicator::drawBackground(void) {
+QRect QNeedleIndicator::needleRect(qreal val) {
+    int side = qMin(width(), height());
+
+    /* Same transform as drawNeedle; the needle polygon and its hub both */
+    /* fit in this box before rotation                                   */
+    QTransform transform;
+    transform.translate(width() / 2, height() / 2);
+    transform.scale(side / 256.0, side / 256.0);
+    transform.rotate(value2angle(val));
+    QPolygonF outline;
+    outline << QPointF(100,0) << QPointF(0,-5) << QPointF(-30,-5)
+            << QPointF(-30,5) << QPointF(0,5);
+
+    /* pad for antialiasing and the pen */
+    return transform.map(outline).boundingRect().toAlignedRect().adjusted(-2,-2,2,2);
+}
+
+void QNeedleIndicator::drawBackground(QPainter *painter) {
     int side = qMin(width(), height());
     /* Keep side size an even number by trunkating odd pixel */
     side &= ~0x01;
 
     QRadialGradient gradient;
-    QPainter painter(this);
     QPen     pen(Qt::black);
              pen.setWidth(1);
 
     /* Initialize painter */
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.translate(width() / 2, height() / 2);
-    painter.scale(side / 256.0, side / 256.0);
-    painter.setPen(pen);
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->translate(width() / 2, height() / 2);
+    painter->scale(side / 256.0, side / 256.0);
+    painter->setPen(pen);
     /* Draw external circle */
     gradient = QRadialGradient (QPointF(-128,-128), 384, QPointF(-128,-128));
     gradient.setColorAt(0, QColor(224,224,224));
     gradient.setColorAt(1, QColor(28,28,28));
-    painter.setPen(pen);
-    painter.setBrush(QBrush(gradient));
-    painter.drawEllipse(QPoint(0,0),125,125);
+    painter->setPen(pen);
+    painter->setBrush(QBrush(gradient));
+    painter->drawEllipse(QPoint(0,0),125,125);
     /* Draw inner circle */
     gradient = QRadialGradient(QPointF(128,128), 384, QPointF(128,128));
     gradient.setColorAt(0, QColor(224,224,224));
     gradient.setColorAt(1, QColor(28,28,28));
-    painter.setPen(Qt::NoPen);
-    painter.setBrush(QBrush(gradient));
-    painter.drawEllipse(QPoint(0,0),118,118);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(QBrush(gradient));
+    painter->drawEllipse(QPoint(0,0),118,118);
     /* Draw inner shield */
     gradient = QRadialGradient (QPointF(-128,-128), 384, QPointF(-128,-128));
     gradient.setColorAt(0, QColor(255,255,255));
     gradient.setColorAt(1, QColor(224,224,224));
-    painter.setBrush(gradient);
-    painter.setPen(Qt::NoPen);
-    painter.drawEllipse(QPoint(0,0), 115, 115);
-    painter.setPen(pen);
-    painter.setBrush(Qt::black);
-    painter.drawPoint(0,0);
+    painter->setBrush(gradient);
+    painter->setPen(Qt::NoPen);
+    painter->drawEllipse(QPoint(0,0), 115, 115);
+    painter->setPen(pen);
+    painter->setBrush(Qt::black);
+    painter->drawPoint(0,0);
 
     int line = 10; /* FIX #1 */
 
     /* Draw scale majorTicks using coords rotation */
-    painter.save();
-    painter.setBrush(Qt::black);
-    painter.rotate(start_angle);                /* initial angle (first tick) */
-    painter.setBrush(QBrush(Qt::black));
+    painter->save();
+    painter->setBrush(Qt::black);
+    painter->rotate(start_angle);                /* initial angle (first tick) */
+    painter->setBrush(QBrush(Qt::black));
     qreal t_rot = stop_angle/(minorTicks*(majorTicks-1)+majorTicks-1);
     for(int i = 0; i < (minorTicks)*(majorTicks-1)+majorTicks; i++) {
         if( minorTicks ) {
             if( i%(int)(minorTicks+1) == 0 )
-                painter.drawLine(QPoint(105,0), QPoint(105-line, 0));
+                painter->drawLine(QPoint(105,0), QPoint(105-line, 0));
             else
-                painter.drawLine(QPoint(105,0), QPoint(105-line/3, 0));
+                painter->drawLine(QPoint(105,0), QPoint(105-line/3, 0));
         } else {
-            painter.drawLine(QPoint(105,0), QPoint(105-line, 0));
+            painter->drawLine(QPoint(105,0), QPoint(105-line, 0));
         }
-        painter.rotate(t_rot);
+        painter->rotate(t_rot);
     }
-    painter.restore();
+    painter->restore();
 
     /* Draw scale numbers using vector rotation */
     /* x' = xcos(a)-ysin(a)                     */
     /* y' = xsin(a)-ycos(a)                     */
-    painter.save();
+    painter->save();
     qreal rotation = (start_angle/360)*2*M_PI;          /* Initial rotation */
-    painter.setFont(digitFont);
+    painter->setFont(digitFont);
     for(int i = 0; i < majorTicks; i++) {
         QPointF point((70*cos(rotation)), 70*sin(rotation));                           /* calculate digit coords      */
         QString value = QString().sprintf(scaleFormat.constData(), min+(qreal)i*step); /* convert digit to string     */
-        QSize   size  = painter.fontMetrics().size(Qt::TextSingleLine, value);         /* get string size in px       */
+        QSize   size  = painter->fontMetrics().size(Qt::TextSingleLine, value);         /* get string size in px       */
         point.rx() -= size.width()/2;                                                  /* center-align string (horiz) */
         point.ry() += size.height()/4;                                                 /* center-align string (vert)  */
-        painter.drawText(point, value);
-        //painter.drawPoint(point);
+        painter->drawText(point, value);
+        //painter->drawPoint(point);
         rotation+=rot_rad;                                                             /* go to next tick             */
     }
-    painter.restore();
+    painter->restore();
 
     /* Draw meter label */
     if( label.size() ) {
-        painter.setFont(labelFont);
-        QSize   size  = painter.fontMetrics().size(Qt::TextSingleLine, label);
+        painter->setFont(labelFont);
+        QSize   size  = painter->fontMetrics().size(Qt::TextSingleLine, label);
         QPointF point;
         point.rx() -= size.width()/2;       /* center-align string (horiz) */
         point.ry() += size.height()/4 + labelOffset;  /* shift down, below needle    */
-        painter.drawText(point, label);     /* blop!                       */
+        painter->drawText(point, label);     /* blop!                       */
     }
 
 }
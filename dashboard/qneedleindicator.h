@@ -36,18 +36,62 @@
 #include <QDebug>
 #include <QResizeEvent>
 #include <QPainter>
+#include <QPixmap>
+#include <QTransform>
+#include <QPolygonF>
 #include <QString>
 #include <QThread>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QList>
 #include <QtGlobal>
 
+class QNeedleIndicator;
+
+/**
+  * Frame clock shared by all needle indicators. One timer drives every
+  * needle that is still moving and stops as soon as all of them have
+  * settled, so idle gauges don't wake the event loop at all.
+  */
+class QNeedleAnimator : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+      * Returns the application-wide animator.
+      */
+    static QNeedleAnimator *instance(void);
+    /**
+      * Start moving the needle. Does nothing if it is already moving.
+      * @param needle Indicator whose needle is away from its value.
+      */
+    void start(QNeedleIndicator *needle);
+    /**
+      * Stop moving the needle (e.g. when it is destroyed).
+      * @param needle Indicator to drop.
+      */
+    void stop(QNeedleIndicator *needle);
+
+private slots:
+    void tick(void);        // advance every moving needle; fired from QTimer
+
+private:
+    QNeedleAnimator(void);
+
+    QTimer timer;                       // Frame timer, running only while a needle moves
+    QElapsedTimer clock;                // Monotonic time since the previous frame
+    QList<QNeedleIndicator *> moving;   // Needles not settled yet
+};
+
 class QNeedleIndicator : public QWidget {
     Q_OBJECT
+    friend class QNeedleAnimator;
     Q_PROPERTY(qreal    min         READ getMinValue    WRITE setMinValue);
     Q_PROPERTY(qreal    max         READ getMaxValue    WRITE setMaxValue);
     Q_PROPERTY(qreal    value       READ getValue       WRITE setValue);
     Q_PROPERTY(qreal    gap_angle   READ getGapAngle    WRITE setGapAngle);
     Q_PROPERTY(bool     animated    READ isAnimated     WRITE setAnimated);
+    Q_PROPERTY(bool     dialCached  READ isDialCached   WRITE setDialCached);
     Q_PROPERTY(int      majorTicks  READ getMajorTicks  WRITE setMajorTicks);
     Q_PROPERTY(int      minorTicks  READ getMinorTicks  WRITE setMinorTicks);
     Q_PROPERTY(QFont    labelFont   READ getLabelFont   WRITE setLabelFont);
@@ -60,6 +104,7 @@ public:
       * Creates QNeedleIndicator widget with default settings.
       */
     QNeedleIndicator(QWidget *parent = 0);
+    ~QNeedleIndicator();
     /**
      * Set scale major ticks number. Default is 11 ticks. Don't set too many
      * ticks, because scale numbers will overlap.
@@ -147,6 +192,19 @@ public:
       * @returns True if needle is animated. False if not.
       */
     bool isAnimated(void);
+    /**
+      * Set dial caching. If true (the default) the shield, scale and
+      * label are drawn once into a pixmap and blitted back on every
+      * paint. If false they are drawn from scratch every time, which
+      * is only useful to measure what the cache saves.
+      * @param cached Cache the dial when true.
+      */
+    void setDialCached(bool cached);
+    /**
+      * Returns dial caching property.
+      * @returns True if the dial is cached. False if not.
+      */
+    bool isDialCached(void);
     /**
       * Set label text. If label is empty, no label will be drawn.
       * Keep label short and sweet and to the point. It will not
@@ -205,9 +263,6 @@ protected:
     virtual void resizeEvent(QResizeEvent *event);
     virtual void paintEvent (QPaintEvent  *event);
 
-private slots:
-    void animate(void);     // needle animation; fired from QTimer
-
 public slots:
     /**
       * Set indicator value. If animated, this will also start needle animation. If
@@ -216,6 +271,14 @@ public slots:
       */
     void setValue(qreal value);
 
+signals:
+    /**
+      * Emitted after every repaint, e.g. to find out when a value actually
+      * became visible.
+      * @param us Time spent painting, in microseconds.
+      */
+    void painted(int us);
+
 private:
     qreal max;              // max indicator value (final on scale)
     qreal min;              // min indicator value (first on scale)
@@ -230,16 +293,20 @@ private:
     QFont labelFont;
     QString label;
     QByteArray scaleFormat; // scale format string
-    QTimer *timer;          // Animation timer
-    int   animFrame;        // Animation frame coutner
-    qreal valueDelta;       // Delta between current and target needle position value. Used in animation
+    qreal velocity;         // Needle speed during animation, in value units per second
     bool  animated;         // Animation flag. Animate needle when true
     qreal labelOffset;      // Label position between axis needle (when 0.0) and shield edge (when 1.0)
+    QPixmap dial;           // Cached shield, scale and label; everything but the needle
+    bool  dialValid;        // False when size/range/fonts changed and dial must be redrawn
+    bool  dialCached;       // Draw the dial through the pixmap (false only for benchmarking)
 
-    void  drawBackground(void);     /*!< Draw background shield        */
-    void  drawNeedle(void);         /*!< Draw needle                   */
+    void  drawBackground(QPainter *painter); /*!< Draw background shield        */
+    void  drawNeedle(QPainter *painter);     /*!< Draw needle                   */
+    QRect needleRect(qreal value);  /*!< Area covered by the needle at value */
+    void  invalidateDial(void);     /*!< Redraw dial on next paint     */
     qreal value2angle(qreal value); /*!< Convert value to needle angle */
-    void  startAnimation(void);     /*!< Start animation timer         */
+    void  startAnimation(void);     /*!< Hand needle to the animator   */
+    bool  animate(qreal dt);        /*!< Move needle dt seconds closer; true when settled */
 };
 
 #endif // QNEEDLEINDICATOR_H
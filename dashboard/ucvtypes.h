@@ -16,6 +16,7 @@ typedef struct ecustate_struct {
     double batt; // in volts
     double maf; // in mg/sec
     int tach_count;
+    long long acquired; // monotonic time the sample was read (in us, see LatencyClock), 0 if unknown
 } ecustate_t;
 
 typedef char gpsdir_t;
@@ -42,6 +43,7 @@ typedef struct gpsstate_struct {
     double alt; // in m
     double speed; // in mph
     double heading; // in degrees
+    long long acquired; // monotonic time the sample was read (in us, see LatencyClock), 0 if unknown
 } gpsstate_t;
 
 typedef struct imustate_struct {
@@ -52,6 +54,7 @@ typedef struct imustate_struct {
     double gx; // in degs/sec
     double gy; // in degs/sec
     double gz; // in degs/sec
+    long long acquired; // monotonic time the sample was read (in us, see LatencyClock), 0 if unknown
 } imustate_t;
 
 typedef struct ltsstate_struct {
@@ -63,4 +66,36 @@ typedef struct ltsstate_struct {
     bool hazards;
 } ltsstate_t;
 
+typedef struct lapevent_struct {
+    int timestamp; // in ms since the timer was started
+    int lap; // number of the lap just completed (first lap is 1)
+} lapevent_t;
+
+// number of buckets in a latency histogram, bucket i counts
+// everything from 2^i up to 2^(i+1) us (bucket 0 also takes anything under 1 us)
+#define LATENCY_BUCKETS 24
+
+typedef struct latencyhist_struct {
+    int timestamp; // in ms since the timer was started
+    int channel; // see latency_channel_t in LatencyMonitor.h
+    int kind; // see latency_kind_t in LatencyMonitor.h
+    unsigned int counts[LATENCY_BUCKETS];
+} latencyhist_t;
+
+// a single decoded log record, tagged with its record type
+// (see the record type identifiers in DataLogger.h)
+// every state starts with its timestamp, so record.ecu.timestamp
+// is valid no matter which type the record holds
+typedef struct logrecord_struct {
+    int type;
+    union {
+        ecustate_t ecu;
+        gpsstate_t gps;
+        imustate_t imu;
+        ltsstate_t lts;
+        lapevent_t lap;
+        latencyhist_t lat;
+    };
+} logrecord_t;
+
 #endif // UCVTYPES_H
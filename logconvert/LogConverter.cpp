@@ -0,0 +1,419 @@
+#include "LogConverter.h"
+
+#include <cstdio>
+#include <cstring>
+
+// column layout of each converted record type, positions are written
+// as signed decimal degrees rather than degree/minute/direction triples
+static const char *table_names[CONVERT_TABLES] = { "ecu", "gps", "imu", "lts" };
+static const int table_types[CONVERT_TABLES] = { ECU_RECORD, GPS_RECORD, IMU_RECORD, LTS_RECORD };
+static const int table_columns[CONVERT_TABLES] = { 11, 9, 7, 6 };
+static const char *column_names[CONVERT_TABLES][CONVERT_MAX_COLUMNS] = {
+    { "timestamp", "rpm", "spark_adv", "cranking", "map", "mat", "clt", "tps", "batt", "maf", "tach_count" },
+    { "timestamp", "utc_hrs", "utc_mins", "utc_secs", "latitude", "longitude", "alt", "speed", "heading" },
+    { "timestamp", "ax", "ay", "az", "gx", "gy", "gz" },
+    { "timestamp", "headlights", "brakelights", "left_turn", "right_turn", "hazards" }
+};
+static const int column_decimals[CONVERT_TABLES][CONVERT_MAX_COLUMNS] = {
+    { 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 0 },
+    { 0, 0, 0, 3, 7, 7, 1, 2, 1 },
+    { 0, 4, 4, 4, 3, 3, 3 },
+    { 0, 0, 0, 0, 0, 0 }
+};
+
+static const quint64 powers_of_ten[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL
+};
+
+static int TableIndex(int type)
+{
+    for (int i = 0; i < CONVERT_TABLES; i++)
+    {
+        if (table_types[i] == type) return i;
+    }
+    return -1;
+}
+
+static double Degrees(int deg, double mins, gpsdir_t dir)
+{
+    double v = deg + mins / 60.0;
+    return (dir == GPS_SOUTH || dir == GPS_WEST) ? -v : v;
+}
+
+// pulls the columns of a record out as doubles, returns the column count
+static int ExtractColumns(const logrecord_t &r, double *out)
+{
+    switch (r.type)
+    {
+    case ECU_RECORD:
+        out[0] = r.ecu.timestamp;
+        out[1] = r.ecu.rpm;
+        out[2] = r.ecu.spark_adv;
+        out[3] = r.ecu.cranking;
+        out[4] = r.ecu.map;
+        out[5] = r.ecu.mat;
+        out[6] = r.ecu.clt;
+        out[7] = r.ecu.tps;
+        out[8] = r.ecu.batt;
+        out[9] = r.ecu.maf;
+        out[10] = r.ecu.tach_count;
+        return 11;
+    case GPS_RECORD:
+        out[0] = r.gps.timestamp;
+        out[1] = r.gps.utc_hrs;
+        out[2] = r.gps.utc_mins;
+        out[3] = r.gps.utc_secs;
+        out[4] = Degrees(r.gps.pos.lat_deg, r.gps.pos.lat_mins, r.gps.pos.lat_dir);
+        out[5] = Degrees(r.gps.pos.long_deg, r.gps.pos.long_mins, r.gps.pos.long_dir);
+        out[6] = r.gps.alt;
+        out[7] = r.gps.speed;
+        out[8] = r.gps.heading;
+        return 9;
+    case IMU_RECORD:
+        out[0] = r.imu.timestamp;
+        out[1] = r.imu.ax;
+        out[2] = r.imu.ay;
+        out[3] = r.imu.az;
+        out[4] = r.imu.gx;
+        out[5] = r.imu.gy;
+        out[6] = r.imu.gz;
+        return 7;
+    case LTS_RECORD:
+        out[0] = r.lts.timestamp;
+        out[1] = r.lts.headlights;
+        out[2] = r.lts.brakelights;
+        out[3] = r.lts.left_turn;
+        out[4] = r.lts.right_turn;
+        out[5] = r.lts.hazards;
+        return 6;
+    }
+    return 0;
+}
+
+int FormatInt(char *out, qint64 v)
+{
+    char digits[20];
+    int n = 0;
+    int len = 0;
+
+    quint64 u = (v < 0) ? (quint64)(-(v + 1)) + 1 : (quint64)v;
+    if (v < 0) out[len++] = '-';
+
+    do
+    {
+        digits[n++] = '0' + (char)(u % 10);
+        u /= 10;
+    } while (u != 0);
+
+    while (n > 0) out[len++] = digits[--n];
+    return len;
+}
+
+int FormatDouble(char *out, double v, int decimals)
+{
+    // anything too big for fixed point in 64 bits (or not a number)
+    // goes the slow way through the C library
+    if (v != v || v > 1e10 || v < -1e10 || decimals < 0 || decimals > 8)
+    {
+        return sprintf(out, "%.17g", v);
+    }
+
+    bool negative = v < 0;
+    if (negative) v = -v;
+
+    // round once to the requested number of decimals, then print
+    // the whole and fractional parts as integers
+    quint64 fixed = (quint64)(v * powers_of_ten[decimals] + 0.5);
+    quint64 whole = fixed / powers_of_ten[decimals];
+    quint64 frac = fixed % powers_of_ten[decimals];
+
+    int len = 0;
+    if (negative && fixed != 0) out[len++] = '-';
+    len += FormatInt(out + len, (qint64)whole);
+
+    if (decimals > 0)
+    {
+        out[len++] = '.';
+        for (int i = decimals - 1; i >= 0; i--)
+        {
+            out[len + i] = '0' + (char)(frac % 10);
+            frac /= 10;
+        }
+        len += decimals;
+    }
+
+    return len;
+}
+
+OutputBuffer::OutputBuffer()
+{
+    file = NULL;
+    buffer = new char[CONVERT_BUFFER_SIZE];
+    used = 0;
+    failed = false;
+}
+
+OutputBuffer::~OutputBuffer()
+{
+    Close();
+    delete [] buffer;
+}
+
+bool OutputBuffer::Open(QString filepath)
+{
+    Close();
+
+    file = new QFile(filepath);
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        delete file;
+        file = NULL;
+        return false;
+    }
+
+    used = 0;
+    failed = false;
+    return true;
+}
+
+bool OutputBuffer::Close()
+{
+    if (file == NULL) return !failed;
+
+    Flush();
+    file->close();
+    delete file;
+    file = NULL;
+
+    return !failed;
+}
+
+void OutputBuffer::Append(const char *s, int len)
+{
+    while (len > 0)
+    {
+        if (used == CONVERT_BUFFER_SIZE) Flush();
+
+        int n = qMin(len, CONVERT_BUFFER_SIZE - used);
+        memcpy(buffer + used, s, n);
+        used += n;
+        s += n;
+        len -= n;
+    }
+}
+
+void OutputBuffer::AppendInt(qint64 v)
+{
+    if (CONVERT_BUFFER_SIZE - used < 32) Flush();
+    used += FormatInt(buffer + used, v);
+}
+
+void OutputBuffer::AppendDouble(double v, int decimals)
+{
+    if (CONVERT_BUFFER_SIZE - used < 32) Flush();
+    used += FormatDouble(buffer + used, v, decimals);
+}
+
+void OutputBuffer::AppendRawDouble(double v)
+{
+    quint64 bits;
+    memcpy(&bits, &v, sizeof(bits));
+
+    if (CONVERT_BUFFER_SIZE - used < 8) Flush();
+    qToLittleEndian<quint64>(bits, (uchar *)buffer + used);
+    used += 8;
+}
+
+void OutputBuffer::Flush()
+{
+    if (file != NULL && used > 0)
+    {
+        if (file->write(buffer, used) != used) failed = true;
+    }
+    used = 0;
+}
+
+LogConverter::LogConverter(QString input, QDir output_dir, int output_formats)
+{
+    input_path = input;
+    output = output_dir;
+    formats = output_formats;
+    for (int i = 0; i < CONVERT_TABLES; i++) rows[i] = 0;
+}
+
+bool LogConverter::Convert()
+{
+    LogReader reader;
+    if (!reader.Open(input_path))
+    {
+        error = QString("could not open %1").arg(input_path);
+        return false;
+    }
+
+    QString base = QFileInfo(input_path).completeBaseName();
+
+    // one csv per record type, all written in the same pass
+    OutputBuffer csv[CONVERT_TABLES];
+    if (formats & CONVERT_CSV)
+    {
+        for (int t = 0; t < CONVERT_TABLES; t++)
+        {
+            QString filename = QString("%1_%2.csv").arg(base).arg(table_names[t]);
+            if (!csv[t].Open(output.absoluteFilePath(filename)))
+            {
+                error = QString("could not create %1").arg(filename);
+                return false;
+            }
+
+            for (int c = 0; c < table_columns[t]; c++)
+            {
+                if (c > 0) csv[t].Append(',');
+                csv[t].Append(column_names[t][c], strlen(column_names[t][c]));
+            }
+            csv[t].Append('\n');
+        }
+    }
+
+    // the columnar file is written as it goes, a row group at a time
+    QString columnar_path = output.absoluteFilePath(base + ".ucc");
+    if (formats & CONVERT_COLUMNAR)
+    {
+        if (!OpenColumnar(columnar_path)) return false;
+    }
+
+    logrecord_t record;
+    double values[CONVERT_MAX_COLUMNS];
+    while (reader.Next(&record))
+    {
+        int t = TableIndex(record.type);
+        if (t < 0) continue;
+
+        int n = ExtractColumns(record, values);
+
+        if (formats & CONVERT_CSV)
+        {
+            for (int c = 0; c < n; c++)
+            {
+                if (c > 0) csv[t].Append(',');
+                if (column_decimals[t][c] == 0)
+                {
+                    csv[t].AppendInt((qint64)values[c]);
+                }
+                else
+                {
+                    csv[t].AppendDouble(values[c], column_decimals[t][c]);
+                }
+            }
+            csv[t].Append('\n');
+        }
+
+        if (formats & CONVERT_COLUMNAR)
+        {
+            for (int c = 0; c < n; c++) columns[t][c].append(values[c]);
+            rows[t]++;
+            if (rows[t] == CONVERT_ROW_GROUP) WriteRowGroup(t);
+        }
+    }
+
+    for (int t = 0; t < CONVERT_TABLES; t++)
+    {
+        if ((formats & CONVERT_CSV) && !csv[t].Close())
+        {
+            error = QString("error writing %1_%2.csv").arg(base).arg(table_names[t]);
+            return false;
+        }
+    }
+
+    if (formats & CONVERT_COLUMNAR)
+    {
+        for (int t = 0; t < CONVERT_TABLES; t++)
+        {
+            if (rows[t] > 0) WriteRowGroup(t);
+        }
+
+        if (!columnar.Close())
+        {
+            error = QString("error writing %1").arg(columnar_path);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool LogConverter::OpenColumnar(QString filepath)
+{
+    if (!columnar.Open(filepath))
+    {
+        error = QString("could not create %1").arg(filepath);
+        return false;
+    }
+
+    uchar word[4];
+    columnar.Append(COLUMNAR_MAGIC, 4);
+    qToLittleEndian<quint32>(CONVERT_TABLES, word);
+    columnar.Append((const char *)word, 4);
+
+    for (int t = 0; t < CONVERT_TABLES; t++)
+    {
+        columnar.Append((char)table_types[t]);
+        columnar.Append((char)table_columns[t]);
+
+        for (int c = 0; c < table_columns[t]; c++)
+        {
+            int len = strlen(column_names[t][c]);
+            columnar.Append((char)len);
+            columnar.Append(column_names[t][c], len);
+
+            // allocated once, every group after the first reuses it
+            columns[t][c].reserve(CONVERT_ROW_GROUP);
+        }
+    }
+
+    return true;
+}
+
+void LogConverter::WriteRowGroup(int t)
+{
+    uchar word[4];
+    columnar.Append((char)t);
+    qToLittleEndian<quint32>(rows[t], word);
+    columnar.Append((const char *)word, 4);
+
+    for (int c = 0; c < table_columns[t]; c++)
+    {
+        const double *values = columns[t][c].constData();
+        for (int i = 0; i < rows[t]; i++) columnar.AppendRawDouble(values[i]);
+
+        // resize(0) on a reserved vector keeps its memory for the next group
+        columns[t][c].resize(0);
+    }
+
+    rows[t] = 0;
+}
+
+ConvertTask::ConvertTask(QString input, QDir output_dir, int output_formats, qint64 input_size, convert_totals_t *totals)
+{
+    input_path = input;
+    output = output_dir;
+    formats = output_formats;
+    size = input_size;
+    results = totals;
+}
+
+void ConvertTask::run()
+{
+    LogConverter converter(input_path, output, formats);
+
+    if (converter.Convert())
+    {
+        results->converted.fetchAndAddRelaxed(1);
+        results->kbytes.fetchAndAddRelaxed((int)(size / 1024));
+    }
+    else
+    {
+        results->failed.fetchAndAddRelaxed(1);
+        QMutexLocker lock(&results->errors_mutex);
+        results->errors.append(converter.Error());
+    }
+}
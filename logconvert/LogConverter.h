@@ -0,0 +1,121 @@
+#ifndef LOGCONVERTER_H
+#define LOGCONVERTER_H
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <QVector>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QStringList>
+#include <QtEndian>
+
+#include "LogReader.h"
+#include "ucvtypes.h"
+
+// output formats (can be combined)
+#define CONVERT_CSV 0x01
+#define CONVERT_COLUMNAR 0x02
+
+// bytes held in memory before they're written out to an output file
+#define CONVERT_BUFFER_SIZE 65536
+
+// the number of record types that get converted (ecu, gps, imu, lts)
+#define CONVERT_TABLES 4
+
+// the most columns any one record type converts to
+#define CONVERT_MAX_COLUMNS 11
+
+// rows of a table held in memory before they're written out as a group
+#define CONVERT_ROW_GROUP 4096
+
+// columnar files start with this, then a table count (quint32), then for
+// each table its record type (quint8) and column count (quint8) followed
+// by each column's name length (quint8) and name
+// the rest of the file is row groups: a table index (quint8), row count
+// (quint32, at most CONVERT_ROW_GROUP) and each column's rows of float64
+// values in turn, all little-endian
+#define COLUMNAR_MAGIC "UCC2"
+
+// fast number formatting for csv output, returns the number of characters
+// written to out (which must hold at least 32 characters)
+int FormatInt(char *out, qint64 v);
+int FormatDouble(char *out, double v, int decimals);
+
+// buffered, append-only writer so output streams out in big chunks
+class OutputBuffer
+{
+public:
+    OutputBuffer();
+    ~OutputBuffer();
+
+    bool Open(QString filepath);
+    bool Close();
+
+    void Append(const char *s, int len);
+    void Append(char c) { if (used == CONVERT_BUFFER_SIZE) Flush(); buffer[used++] = c; }
+    void AppendInt(qint64 v);
+    void AppendDouble(double v, int decimals);
+    void AppendRawDouble(double v);
+    void Flush();
+
+private:
+    QFile *file;
+    char *buffer;
+    int used;
+    bool failed;
+};
+
+// converts a single .ucv log into csv files (one per record type)
+// and/or a single columnar file
+class LogConverter
+{
+public:
+    LogConverter(QString input, QDir output_dir, int output_formats);
+
+    bool Convert();
+    QString Error() { return error; }
+
+private:
+    QString input_path;
+    QDir output;
+    int formats;
+    QString error;
+
+    // the current row group of each table, a log is never held whole
+    OutputBuffer columnar;
+    QVector<double> columns[CONVERT_TABLES][CONVERT_MAX_COLUMNS];
+    int rows[CONVERT_TABLES];
+
+    bool OpenColumnar(QString filepath);
+    void WriteRowGroup(int table);
+};
+
+// totals shared by all the conversion tasks
+struct convert_totals_t
+{
+    QAtomicInt converted;
+    QAtomicInt failed;
+    QAtomicInt kbytes;
+    QMutex errors_mutex;
+    QStringList errors;
+};
+
+// one log file's worth of work for the thread pool
+class ConvertTask : public QRunnable
+{
+public:
+    ConvertTask(QString input, QDir output_dir, int output_formats, qint64 input_size, convert_totals_t *totals);
+    void run();
+
+private:
+    QString input_path;
+    QDir output;
+    int formats;
+    qint64 size;
+    convert_totals_t *results;
+};
+
+#endif // LOGCONVERTER_H
@@ -0,0 +1,15 @@
+# -------------------------------------------------
+# Batch converter from .ucv logs to CSV and columnar files
+# -------------------------------------------------
+TARGET = logconvert
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+INCLUDEPATH += ../dashboard
+SOURCES += main.cpp \
+    LogConverter.cpp \
+    ../dashboard/LogReader.cpp
+HEADERS += LogConverter.h \
+    ../dashboard/LogReader.h \
+    ../dashboard/ucvtypes.h
@@ -0,0 +1,98 @@
+#include <QCoreApplication>
+#include <QThread>
+#include <QThreadPool>
+#include <QFileInfo>
+#include <QTime>
+#include <QDir>
+
+#include <cstdio>
+
+#include "LogConverter.h"
+
+static void Usage()
+{
+    fprintf(stderr, "usage: logconvert [-j threads] [--csv] [--columnar] <log directory> [output directory]\n");
+    fprintf(stderr, "converts every .ucv log in the directory, to both formats unless one is picked\n");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+
+    int formats = 0;
+    int threads = QThread::idealThreadCount();
+    QStringList dirs;
+    for (int i = 1; i < args.size(); i++)
+    {
+        if (args[i] == "--csv")
+        {
+            formats |= CONVERT_CSV;
+        }
+        else if (args[i] == "--columnar")
+        {
+            formats |= CONVERT_COLUMNAR;
+        }
+        else if (args[i] == "-j" && i + 1 < args.size())
+        {
+            threads = args[++i].toInt();
+        }
+        else if (args[i].startsWith("-"))
+        {
+            Usage();
+            return 1;
+        }
+        else
+        {
+            dirs.append(args[i]);
+        }
+    }
+
+    if (dirs.size() < 1 || dirs.size() > 2)
+    {
+        Usage();
+        return 1;
+    }
+    if (formats == 0) formats = CONVERT_CSV | CONVERT_COLUMNAR;
+    if (threads < 1) threads = 1;
+
+    QDir input(dirs[0]);
+    QDir output(dirs.size() > 1 ? dirs[1] : dirs[0]);
+    if (!input.exists())
+    {
+        fprintf(stderr, "logconvert: %s does not exist\n", qPrintable(dirs[0]));
+        return 1;
+    }
+    if (!output.exists() && !output.mkpath("."))
+    {
+        fprintf(stderr, "logconvert: could not create %s\n", qPrintable(output.path()));
+        return 1;
+    }
+
+    // every log is an independent task; hand out the biggest ones first
+    // so a long race log never ends up running alone at the very end
+    QFileInfoList logs = input.entryInfoList(QStringList("*.ucv"), QDir::Files, QDir::Size);
+
+    QTime time;
+    time.start();
+
+    convert_totals_t totals;
+    QThreadPool *pool = QThreadPool::globalInstance();
+    pool->setMaxThreadCount(threads);
+    for (int i = 0; i < logs.size(); i++)
+    {
+        pool->start(new ConvertTask(logs[i].absoluteFilePath(), output, formats, logs[i].size(), &totals));
+    }
+    pool->waitForDone();
+
+    for (int i = 0; i < totals.errors.size(); i++)
+    {
+        fprintf(stderr, "logconvert: %s\n", qPrintable(totals.errors[i]));
+    }
+
+    double secs = time.elapsed() / 1000.0;
+    printf("converted %d of %d logs (%.1f MB) in %.2f s using %d threads\n",
+           (int)totals.converted, logs.size(), (int)totals.kbytes / 1024.0, secs, threads);
+
+    return ((int)totals.failed == 0) ? 0 : 1;
+}
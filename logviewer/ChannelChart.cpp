@@ -0,0 +1,173 @@
+#include "ChannelChart.h"
+
+ChannelChart::ChannelChart(LogData *log_data, int chart_channel, QWidget *parent)
+    : QWidget(parent)
+{
+    data = log_data;
+    channel = chart_channel;
+    view_t0 = data->StartTime();
+    view_t1 = data->EndTime();
+    cursor_t = view_t0;
+    drag_x = 0;
+    drag_t0 = 0;
+
+    setMinimumHeight(CHART_HEIGHT);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    // reserving marks the vectors as sized by hand, so resize(0) each
+    // frame keeps the memory instead of giving it back
+    spans.reserve(2048);
+    points.reserve(2048);
+}
+
+void ChannelChart::SetView(int t0, int t1)
+{
+    if (t0 == view_t0 && t1 == view_t1) return;
+
+    view_t0 = t0;
+    view_t1 = t1;
+    update();
+}
+
+void ChannelChart::SetCursor(int t)
+{
+    if (t == cursor_t) return;
+
+    // only the old and new cursor columns (plus the value readout) change
+    int old_x = (int)TimeToX(cursor_t);
+    cursor_t = t;
+    int new_x = (int)TimeToX(cursor_t);
+    update(old_x - 1, 0, 3, height());
+    update(new_x - 1, 0, 3, height());
+    update(0, 0, width(), 16);
+}
+
+int ChannelChart::XToTime(int x)
+{
+    return view_t0 + (int)((qint64)(view_t1 - view_t0) * x / qMax(width(), 1));
+}
+
+double ChannelChart::TimeToX(int t)
+{
+    if (view_t1 == view_t0) return 0;
+    return (double)(t - view_t0) * width() / (view_t1 - view_t0);
+}
+
+double ChannelChart::ValueToY(double v)
+{
+    // leave room at the top for the channel name
+    double lo = data->MinValue(channel);
+    double hi = data->MaxValue(channel);
+    if (hi <= lo) hi = lo + 1.0;
+
+    double top = 18;
+    double bottom = height() - 4;
+    return bottom - (v - lo) * (bottom - top) / (hi - lo);
+}
+
+void ChannelChart::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.setClipRect(event->rect());
+    painter.fillRect(event->rect(), Qt::white);
+    painter.setPen(QColor(200, 200, 200));
+    painter.drawLine(0, height() - 1, width(), height() - 1);
+
+    int w = width();
+    int level = data->pyramid.ChooseLevel(channel, view_t0, view_t1, w);
+
+    painter.setPen(Qt::darkBlue);
+    if (level < 0)
+    {
+        // zoomed in far enough to draw the samples themselves, only
+        // this stretch of the log gets decoded
+        data->LoadView(view_t0, view_t1);
+        int n = data->SampleCount(channel);
+        const int *ts = data->Times(channel);
+        const float *vs = data->Values(channel);
+        int first = data->FindSample(channel, view_t0);
+
+        points.resize(0);
+        for (int i = first; i < n; i++)
+        {
+            points.append(QPointF(TimeToX(ts[i]), ValueToY(vs[i])));
+            if (ts[i] > view_t1) break;
+        }
+        painter.drawPolyline(points.constData(), points.size());
+    }
+    else
+    {
+        // one min/max span per bucket plus a line through the means
+        int n = data->pyramid.BucketCount(channel, level);
+        const pyramidbucket_t *buckets = data->pyramid.Buckets(channel, level);
+        int first = data->pyramid.FindBucket(channel, level, view_t0);
+
+        spans.resize(0);
+        points.resize(0);
+        for (int i = first; i < n && buckets[i].t_start <= view_t1; i++)
+        {
+            double x = TimeToX((buckets[i].t_start + buckets[i].t_end) / 2);
+            spans.append(QLineF(x, ValueToY(buckets[i].min), x, ValueToY(buckets[i].max)));
+            points.append(QPointF(x, ValueToY(buckets[i].mean)));
+        }
+        painter.setPen(QColor(150, 170, 230));
+        painter.drawLines(spans.constData(), spans.size());
+        painter.setPen(Qt::darkBlue);
+        painter.drawPolyline(points.constData(), points.size());
+    }
+
+    // synchronized cursor and the value under it
+    double cx = TimeToX(cursor_t);
+    painter.setPen(Qt::red);
+    painter.drawLine(QPointF(cx, 0), QPointF(cx, height()));
+
+    painter.setPen(Qt::black);
+    painter.drawText(4, 13, QString("%1: %2").arg(LogPyramid::ChannelName(channel))
+                            .arg(data->ValueAt(channel, cursor_t), 0, 'f', 2));
+}
+
+void ChannelChart::mousePressEvent(QMouseEvent *event)
+{
+    drag_x = event->x();
+    drag_t0 = view_t0;
+
+    if (event->button() == Qt::LeftButton)
+    {
+        emit CursorChanged(XToTime(event->x()));
+    }
+}
+
+void ChannelChart::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton)
+    {
+        // left drags the cursor
+        emit CursorChanged(XToTime(event->x()));
+    }
+    else if (event->buttons() & (Qt::RightButton | Qt::MidButton))
+    {
+        // right (or middle) drags pan the view
+        int span = view_t1 - view_t0;
+        int shift = (int)((qint64)span * (drag_x - event->x()) / qMax(width(), 1));
+        int t0 = drag_t0 + shift;
+        t0 = qMax(t0, data->StartTime());
+        t0 = qMin(t0, data->EndTime() - span);
+        emit ViewChanged(t0, t0 + span);
+    }
+}
+
+void ChannelChart::wheelEvent(QWheelEvent *event)
+{
+    // zoom around the time under the mouse
+    int anchor = XToTime(event->x());
+    double factor = (event->delta() > 0) ? 0.8 : 1.25;
+
+    int t0 = anchor - (int)((anchor - view_t0) * factor);
+    int t1 = anchor + (int)((view_t1 - anchor) * factor);
+    if (t1 - t0 < CHART_MIN_SPAN) return;
+
+    t0 = qMax(t0, data->StartTime());
+    t1 = qMin(t1, data->EndTime());
+    emit ViewChanged(t0, t1);
+}
@@ -0,0 +1,66 @@
+#ifndef CHANNELCHART_H
+#define CHANNELCHART_H
+
+#include <QWidget>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QVector>
+#include <QLineF>
+#include <QPointF>
+
+#include "LogData.h"
+
+// height of a single channel's strip chart (in pixels)
+#define CHART_HEIGHT 90
+
+// how far in (in ms across the whole chart) the view can zoom
+#define CHART_MIN_SPAN 500
+
+// strip chart of one channel of a log, drawn at the level of detail that
+// gives about one overview bucket per pixel so a frame never depends on
+// how many samples are in view
+class ChannelChart : public QWidget
+{
+    Q_OBJECT
+
+public:
+    ChannelChart(LogData *log_data, int chart_channel, QWidget *parent = 0);
+
+    virtual QSize sizeHint() const { return QSize(600, CHART_HEIGHT); }
+
+public slots:
+    void SetView(int t0, int t1);
+    void SetCursor(int t);
+
+signals:
+    // the user dragged/zoomed or moved the cursor on this chart
+    void ViewChanged(int t0, int t1);
+    void CursorChanged(int t);
+
+protected:
+    virtual void paintEvent(QPaintEvent *event);
+    virtual void mousePressEvent(QMouseEvent *event);
+    virtual void mouseMoveEvent(QMouseEvent *event);
+    virtual void wheelEvent(QWheelEvent *event);
+
+private:
+    LogData *data;
+    int channel;
+    int view_t0;
+    int view_t1;
+    int cursor_t;
+    int drag_x;
+    int drag_t0;
+
+    // reused every frame so painting doesn't allocate
+    QVector<QLineF> spans;
+    QVector<QPointF> points;
+
+    int XToTime(int x);
+    double TimeToX(int t);
+    double ValueToY(double v);
+};
+
+#endif // CHANNELCHART_H
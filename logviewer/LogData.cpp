@@ -0,0 +1,221 @@
+#include "LogData.h"
+
+#include <climits>
+
+LogData::LogData()
+{
+    t_first = 0;
+    t_last = 0;
+    for (int c = 0; c < PYR_CHANNELS; c++)
+    {
+        min_value[c] = 0;
+        max_value[c] = 0;
+
+        // reserving marks the columns as sized by hand, so reloading a
+        // window with resize(0) keeps the memory
+        view.times[c].reserve(4096);
+        view.values[c].reserve(4096);
+        cursor.times[c].reserve(1024);
+        cursor.values[c].reserve(1024);
+    }
+    view.t0 = cursor.t0 = 0;
+    view.t1 = cursor.t1 = -1;
+}
+
+bool LogData::Open(QString filepath)
+{
+    reader.Close();
+    if (!reader.Open(filepath)) return false;
+
+    // use the overview the logger saved, or build one in the same pass
+    // that builds the seek index
+    bool have_pyramid = pyramid.Load(LogPyramid::PathFor(filepath));
+    if (!have_pyramid) pyramid.Clear();
+
+    // one pass straight through the mapped log, nothing is kept but an
+    // index entry every LOGDATA_INDEX_STRIDE records
+    index.clear();
+    bool first = true;
+    int count = 0;
+    logrecord_t r;
+    while (true)
+    {
+        qint64 offset = reader.Position();
+        if (!reader.Next(&r)) break;
+
+        if (count % LOGDATA_INDEX_STRIDE == 0)
+        {
+            logindex_t entry;
+            entry.offset = offset;
+            entry.t_before = first ? INT_MIN : t_last;
+            index.append(entry);
+        }
+        count++;
+
+        int t = r.ecu.timestamp;
+        if (first || t < t_first) t_first = t;
+        if (first || t > t_last) t_last = t;
+        first = false;
+
+        if (!have_pyramid) pyramid.Add(r);
+    }
+
+    if (first)
+    {
+        t_first = 0;
+        t_last = 0;
+    }
+
+    if (!have_pyramid)
+    {
+        pyramid.Finish();
+        pyramid.Save(LogPyramid::PathFor(filepath));
+    }
+
+    // chart scales come from the coarsest level with anything in it
+    for (int c = 0; c < PYR_CHANNELS; c++)
+    {
+        min_value[c] = 0;
+        max_value[c] = 0;
+        for (int l = PYRAMID_LEVELS - 1; l >= 0; l--)
+        {
+            int n = pyramid.BucketCount(c, l);
+            if (n == 0) continue;
+
+            const pyramidbucket_t *buckets = pyramid.Buckets(c, l);
+            min_value[c] = buckets[0].min;
+            max_value[c] = buckets[0].max;
+            for (int i = 1; i < n; i++)
+            {
+                if (buckets[i].min < min_value[c]) min_value[c] = buckets[i].min;
+                if (buckets[i].max > max_value[c]) max_value[c] = buckets[i].max;
+            }
+            break;
+        }
+    }
+
+    // nothing decoded yet
+    view.t1 = view.t0 - 1;
+    cursor.t1 = cursor.t0 - 1;
+    return true;
+}
+
+void LogData::LoadView(int t0, int t1)
+{
+    if (view.t1 >= view.t0 && t0 >= view.t0 && t1 <= view.t1) return;
+
+    // half a view of slack either side covers small pans and the line
+    // running off both edges
+    int slack = (t1 - t0) / 2;
+    Load(&view, t0 - slack, t1 + slack);
+}
+
+void LogData::Load(logwindow_t *window, int t0, int t1)
+{
+    for (int c = 0; c < PYR_CHANNELS; c++)
+    {
+        window->times[c].resize(0);
+        window->values[c].resize(0);
+    }
+    window->t0 = t0;
+    window->t1 = t1;
+    if (index.isEmpty()) return;
+
+    // the last index entry with everything before it earlier than t0,
+    // t_before only ever goes up so it can be searched
+    int lo = 0;
+    int hi = index.size();
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (index[mid].t_before < t0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    reader.Seek(index[(lo > 0) ? lo - 1 : 0].offset);
+
+    // the few records before t0 are kept too, so there's always a sample
+    // at or before the start of the window
+    logrecord_t r;
+    while (reader.Next(&r))
+    {
+        int t = r.ecu.timestamp;
+        if (t > t1) break;
+
+        switch (r.type)
+        {
+        case ECU_RECORD:
+            Append(window, PYR_RPM, t, r.ecu.rpm);
+            Append(window, PYR_SPARK_ADV, t, r.ecu.spark_adv);
+            Append(window, PYR_MAP, t, r.ecu.map);
+            Append(window, PYR_MAT, t, r.ecu.mat);
+            Append(window, PYR_CLT, t, r.ecu.clt);
+            Append(window, PYR_TPS, t, r.ecu.tps);
+            Append(window, PYR_BATT, t, r.ecu.batt);
+            Append(window, PYR_MAF, t, r.ecu.maf);
+            break;
+        case GPS_RECORD:
+            Append(window, PYR_SPEED, t, r.gps.speed);
+            Append(window, PYR_ALT, t, r.gps.alt);
+            Append(window, PYR_HEADING, t, r.gps.heading);
+            break;
+        case IMU_RECORD:
+            Append(window, PYR_AX, t, r.imu.ax);
+            Append(window, PYR_AY, t, r.imu.ay);
+            Append(window, PYR_AZ, t, r.imu.az);
+            Append(window, PYR_GX, t, r.imu.gx);
+            Append(window, PYR_GY, t, r.imu.gy);
+            Append(window, PYR_GZ, t, r.imu.gz);
+            break;
+        }
+    }
+}
+
+void LogData::Append(logwindow_t *window, int channel, int timestamp, double value)
+{
+    window->times[channel].append(timestamp);
+    window->values[channel].append(value);
+}
+
+int LogData::Find(const QVector<int> &ts, int t)
+{
+    // binary search for the first sample after t, then step back one
+    int lo = 0;
+    int hi = ts.size();
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (ts[mid] <= t)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return (lo > 0) ? lo - 1 : 0;
+}
+
+int LogData::FindSample(int channel, int t)
+{
+    return Find(view.times[channel], t);
+}
+
+double LogData::ValueAt(int channel, int t)
+{
+    // the cursor has a small window of its own so reading it never
+    // throws away what the charts have loaded
+    if (cursor.t1 < cursor.t0 || t < cursor.t0 || t > cursor.t1)
+    {
+        Load(&cursor, t - LOGDATA_CURSOR_MS, t + LOGDATA_CURSOR_MS);
+    }
+
+    if (cursor.values[channel].isEmpty()) return 0.0;
+    return cursor.values[channel][Find(cursor.times[channel], t)];
+}
@@ -0,0 +1,82 @@
+#ifndef LOGDATA_H
+#define LOGDATA_H
+
+#include <QString>
+#include <QVector>
+#include <QFileInfo>
+
+#include "LogReader.h"
+#include "LogPyramid.h"
+#include "ucvtypes.h"
+
+// records between entries in the seek index
+#define LOGDATA_INDEX_STRIDE 256
+
+// how far either side of the cursor gets decoded for ValueAt (in ms)
+#define LOGDATA_CURSOR_MS 5000
+
+// a log opened for viewing: the file stays mapped, overviews are drawn
+// from its pyramid and only the stretch actually on screen is decoded
+// into time/value columns, so memory doesn't grow with the log
+class LogData
+{
+public:
+    LogData();
+
+    bool Open(QString filepath);
+
+    int StartTime() { return t_first; }
+    int EndTime() { return t_last; }
+
+    // decode [t0, t1] (plus some slack for panning) if it isn't already,
+    // the sample accessors below cover whatever was last loaded
+    void LoadView(int t0, int t1);
+
+    int SampleCount(int channel) { return view.times[channel].size(); }
+    const int *Times(int channel) { return view.times[channel].constData(); }
+    const float *Values(int channel) { return view.values[channel].constData(); }
+
+    // overall range of a channel, for scaling its chart
+    float MinValue(int channel) { return min_value[channel]; }
+    float MaxValue(int channel) { return max_value[channel]; }
+
+    // index of the last loaded sample at or before t (or 0)
+    int FindSample(int channel, int t);
+
+    // the channel's value at time t (the last sample at or before it)
+    double ValueAt(int channel, int t);
+
+    LogPyramid pyramid;
+
+private:
+    // decoded samples of every channel over [t0, t1] of the log
+    typedef struct logwindow_struct
+    {
+        QVector<int> times[PYR_CHANNELS];
+        QVector<float> values[PYR_CHANNELS];
+        int t0;
+        int t1; // t1 < t0 when nothing is loaded
+    } logwindow_t;
+
+    // where to start decoding to be sure of seeing every record from t on
+    typedef struct logindex_struct
+    {
+        qint64 offset;
+        int t_before; // latest timestamp of all the records before offset
+    } logindex_t;
+
+    LogReader reader;
+    QVector<logindex_t> index;
+    logwindow_t view;
+    logwindow_t cursor;
+    float min_value[PYR_CHANNELS];
+    float max_value[PYR_CHANNELS];
+    int t_first;
+    int t_last;
+
+    void Load(logwindow_t *window, int t0, int t1);
+    static void Append(logwindow_t *window, int channel, int timestamp, double value);
+    static int Find(const QVector<int> &times, int t);
+};
+
+#endif // LOGDATA_H
@@ -0,0 +1,126 @@
+#include "LogViewer.h"
+
+LogViewer::LogViewer(QWidget *parent)
+    : QWidget(parent)
+{
+    QGridLayout *layout = new QGridLayout();
+    QVBoxLayout *charts_layout = new QVBoxLayout();
+    QWidget *charts_widget = new QWidget();
+    QScrollArea *scroll = new QScrollArea();
+
+    // controls
+    open_button = new QPushButton("Open Log...");
+    reset_button = new QPushButton("Whole Run");
+    file_label = new QLabel("No log open");
+    cursor_label = new QLabel("0:00.000");
+    cursor_label->setFont(QFont("Fixed", 14, QFont::Bold));
+
+    // gauges show the values under the cursor
+    atach = new QNeedleIndicator();
+    atach->setRange(0, VIEWER_TACH_MAX);
+    atach->setMajorTicks(VIEWER_TACH_MAX / 1000 + 1);
+    atach->setMinorTicks(9);
+    atach->setDigitFormat(QString("%.0f"));
+    atach->setLabel(QString("RPM"));
+    atach->setAnimated(false);
+    atach->setMinimumSize(160, 160);
+
+    aspeed = new QNeedleIndicator();
+    aspeed->setRange(0, VIEWER_SPEED_MAX);
+    aspeed->setMajorTicks(VIEWER_SPEED_MAX / 5 + 1);
+    aspeed->setMinorTicks(4);
+    aspeed->setDigitFormat(QString("%.0f"));
+    aspeed->setLabel(QString("Speed"));
+    aspeed->setAnimated(false);
+    aspeed->setMinimumSize(160, 160);
+
+    // one chart per channel, all sharing the same view and cursor
+    for (int c = 0; c < PYR_CHANNELS; c++)
+    {
+        charts[c] = new ChannelChart(&data, c);
+        charts_layout->addWidget(charts[c]);
+        connect(charts[c], SIGNAL(ViewChanged(int, int)), this, SLOT(SetView(int, int)));
+        connect(charts[c], SIGNAL(CursorChanged(int)), this, SLOT(SetCursor(int)));
+    }
+    charts_layout->setSpacing(1);
+    charts_widget->setLayout(charts_layout);
+    scroll->setWidget(charts_widget);
+    scroll->setWidgetResizable(true);
+
+    layout->addWidget(open_button, 0, 0);
+    layout->addWidget(reset_button, 1, 0);
+    layout->addWidget(file_label, 2, 0);
+    layout->addWidget(cursor_label, 3, 0);
+    layout->addWidget(atach, 4, 0);
+    layout->addWidget(aspeed, 5, 0);
+    layout->setRowStretch(6, 1);
+    layout->addWidget(scroll, 0, 1, 7, 1);
+    layout->setColumnStretch(1, 1);
+
+    setLayout(layout);
+    setWindowTitle("Urban Concept Log Viewer");
+    resize(1024, 700);
+
+    connect(open_button, SIGNAL(clicked()), this, SLOT(OpenButtonClicked()));
+    connect(reset_button, SIGNAL(clicked()), this, SLOT(ResetZoom()));
+}
+
+LogViewer::~LogViewer()
+{
+    // nothing yet
+}
+
+bool LogViewer::OpenLog(QString filepath)
+{
+    QTime time;
+    time.start();
+
+    if (!data.Open(filepath))
+    {
+        QMessageBox msg;
+        msg.setWindowTitle("Error");
+        msg.setText(QString("Could not open %1.").arg(filepath));
+        msg.exec();
+        return false;
+    }
+
+    file_label->setText(QString("%1\n(opened in %2 ms)").arg(QFileInfo(filepath).fileName()).arg(time.elapsed()));
+    ResetZoom();
+    SetCursor(data.StartTime());
+    return true;
+}
+
+void LogViewer::OpenButtonClicked()
+{
+    QString filepath = QFileDialog::getOpenFileName(this, "Open Log File", QString(), "Log Files (*.ucv)");
+    if (!filepath.isEmpty()) OpenLog(filepath);
+}
+
+void LogViewer::ResetZoom()
+{
+    SetView(data.StartTime(), data.EndTime());
+}
+
+void LogViewer::SetView(int t0, int t1)
+{
+    for (int c = 0; c < PYR_CHANNELS; c++)
+    {
+        charts[c]->SetView(t0, t1);
+    }
+}
+
+void LogViewer::SetCursor(int t)
+{
+    for (int c = 0; c < PYR_CHANNELS; c++)
+    {
+        charts[c]->SetCursor(t);
+    }
+
+    atach->setValue(data.ValueAt(PYR_RPM, t));
+    aspeed->setValue(data.ValueAt(PYR_SPEED, t));
+
+    int ms = t - data.StartTime();
+    cursor_label->setText(QString("%1:%2.%3").arg(ms / 60000)
+                          .arg((ms / 1000) % 60, 2, 10, QChar('0'))
+                          .arg(ms % 1000, 3, 10, QChar('0')));
+}
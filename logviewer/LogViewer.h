@@ -0,0 +1,47 @@
+#ifndef LOGVIEWER_H
+#define LOGVIEWER_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QPushButton>
+#include <QGridLayout>
+#include <QVBoxLayout>
+#include <QScrollArea>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QTime>
+
+#include "LogData.h"
+#include "ChannelChart.h"
+#include "qneedleindicator.h"
+
+// tachometer and speedometer ranges, same as the dashboard
+#define VIEWER_TACH_MAX 8000
+#define VIEWER_SPEED_MAX 45
+
+// strip charts of every channel of a log with a cursor shared across all
+// of them, plus the dashboard gauges showing the values at the cursor
+class LogViewer : public QWidget
+{
+    Q_OBJECT
+
+public:
+    LogViewer(QWidget *parent = 0);
+    ~LogViewer();
+
+public slots:
+    bool OpenLog(QString filepath);
+    void OpenButtonClicked();
+    void ResetZoom();
+    void SetView(int t0, int t1);
+    void SetCursor(int t);
+
+private:
+    LogData data;
+    ChannelChart *charts[PYR_CHANNELS];
+    QNeedleIndicator *atach, *aspeed;
+    QPushButton *open_button, *reset_button;
+    QLabel *file_label, *cursor_label;
+};
+
+#endif // LOGVIEWER_H
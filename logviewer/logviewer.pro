@@ -0,0 +1,20 @@
+# -------------------------------------------------
+# Viewer for .ucv logs
+# -------------------------------------------------
+TARGET = logviewer
+TEMPLATE = app
+INCLUDEPATH += ../dashboard
+SOURCES += main.cpp \
+    LogViewer.cpp \
+    LogData.cpp \
+    ChannelChart.cpp \
+    ../dashboard/LogReader.cpp \
+    ../dashboard/LogPyramid.cpp \
+    ../dashboard/qneedleindicator.cpp
+HEADERS += LogViewer.h \
+    LogData.h \
+    ChannelChart.h \
+    ../dashboard/LogReader.h \
+    ../dashboard/LogPyramid.h \
+    ../dashboard/qneedleindicator.h \
+    ../dashboard/ucvtypes.h
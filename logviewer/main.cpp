@@ -0,0 +1,20 @@
+#include <QApplication>
+
+#include "LogViewer.h"
+
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+
+    LogViewer viewer;
+    viewer.show();
+
+    // open a log straight away if one was given on the command line
+    QStringList args = a.arguments();
+    if (args.size() > 1)
+    {
+        viewer.OpenLog(args[1]);
+    }
+
+    return a.exec();
+}